@@ -0,0 +1,267 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "audio_frontend.h"
+
+#include <cstring>
+
+namespace {
+
+// Spectral subtraction parameters, in 1 << kSpectralSubtractionBits units.
+constexpr int kNoiseSmoothingBits = 10;
+constexpr int kSpectralSubtractionBits = 14;
+constexpr uint32_t kSpectralSubtractionOne = 1 << kSpectralSubtractionBits;
+constexpr uint32_t kNoiseSmoothing =
+    (MICRO_FEATURES_NOISE_SMOOTHING << kSpectralSubtractionBits) / 1000;
+constexpr uint32_t kNoiseOneMinusSmoothing =
+    kSpectralSubtractionOne - kNoiseSmoothing;
+constexpr uint32_t kNoiseAlternateSmoothing =
+    (MICRO_FEATURES_NOISE_ALTERNATE_SMOOTHING << kSpectralSubtractionBits) /
+    1000;
+constexpr uint32_t kNoiseAlternateOneMinusSmoothing =
+    kSpectralSubtractionOne - kNoiseAlternateSmoothing;
+constexpr uint32_t kMinSignalRemaining = 819;
+// PCAN and log parameters.
+constexpr int kPcanSnrShift = 6;
+constexpr int kLogInputCorrectionBits = 3;
+constexpr uint32_t kLogOutputScale = 64;
+// The model's final conversion, (log * 256 + 333) / 666 - 128, in int8.
+constexpr int32_t kInt8ScaleNumerator = 256;
+constexpr int32_t kInt8ScaleRounding = 333;
+constexpr int32_t kInt8ScaleDenominator = 666;
+// MFCCs are in the log's units of 1/64, quantized to steps of 1/2.
+constexpr int kMfccOutputShift = 5;
+
+}  // namespace
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::BasicAudioFrontend()
+    : trimmed_filterbank_{kChannelCount,
+                          Tables::kFilterbankWeights.values,
+                          Tables::kFilterbankUnweights.values,
+                          channel_frequency_starts_,
+                          channel_weight_starts_,
+                          channel_widths_} {
+  const FrontendFilterbank padded = {
+      kChannelCount,
+      Tables::kFilterbankWeights.values,
+      Tables::kFilterbankUnweights.values,
+      Tables::kChannelFrequencyStarts.values,
+      Tables::kChannelWeightStarts.values,
+      Tables::kChannelWidths.values,
+  };
+  FrontendTrimFilterbank(padded, channel_frequency_starts_,
+                         channel_weight_starts_, channel_widths_);
+  // Bins outside of the filterbank's range stay zero, as in the model.
+  memset(energy_, 0, sizeof(energy_));
+  Reset();
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::Reset() {
+  memset(noise_estimate_, 0, sizeof(noise_estimate_));
+  DropOverlap();
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::DropOverlap() {
+  has_overlap_ = false;
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::KeepOverlap(
+    const int16_t* window) {
+  memcpy(overlap_, window + kWindowSize - kOverlapCount, sizeof(overlap_));
+  has_overlap_ = true;
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::ProcessWindow(
+    const int16_t* window, int8_t* features, FrontendSliceStats* stats) {
+  ComputeChannels(window, channels_);
+  KeepOverlap(window);
+  ChannelsToFeatures(channels_, features, stats);
+  if (stats != nullptr) {
+    stats->clipped_samples = FrontendCountClipped(window, kWindowSize);
+  }
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+bool BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::PushStride(
+    const int16_t* samples, int8_t* features, FrontendSliceStats* stats) {
+  if (!has_overlap_) {
+    // One stride only makes a whole overlap if the windows overlap by less.
+    if constexpr (kOverlapCount <= kStrideSize) {
+      memcpy(overlap_, samples + kStrideSize - kOverlapCount,
+             sizeof(overlap_));
+      has_overlap_ = true;
+    }
+    return false;
+  }
+  // Window the two parts of the window where they are, rather than joining
+  // them up first.
+  const int16_t overlap_max_abs =
+      FrontendApplyWindow(overlap_, Tables::kWindow.values, kOverlapCount,
+                          kFrontendWindowShift, fft_input_);
+  const int16_t stride_max_abs = FrontendApplyWindow(
+      samples, Tables::kWindow.values + kOverlapCount, kStrideSize,
+      kFrontendWindowShift, fft_input_ + kOverlapCount);
+  if (stats != nullptr) {
+    stats->clipped_samples = FrontendCountClipped(overlap_, kOverlapCount) +
+                             FrontendCountClipped(samples, kStrideSize);
+  }
+  if constexpr (kOverlapCount <= kStrideSize) {
+    memcpy(overlap_, samples + kStrideSize - kOverlapCount, sizeof(overlap_));
+  } else {
+    // The next overlap is the end of this one followed by the whole stride.
+    memmove(overlap_, overlap_ + kStrideSize,
+            (kOverlapCount - kStrideSize) * sizeof(int16_t));
+    memcpy(overlap_ + kOverlapCount - kStrideSize, samples,
+           kStrideSize * sizeof(int16_t));
+  }
+  WindowedToChannels(overlap_max_abs > stride_max_abs ? overlap_max_abs
+                                                      : stride_max_abs,
+                     channels_);
+  ChannelsToFeatures(channels_, features, stats);
+  return true;
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::ProcessSlices(
+    const int16_t* audio, int slice_count, int8_t* features,
+    FrontendSliceStats* stats) {
+  if (slice_count <= 0) {
+    return;
+  }
+  ProcessWindow(audio, features, stats);
+  const int16_t* stride = audio + kWindowSize;
+  for (int i = 1; i < slice_count; ++i) {
+    features += kFeatureCount;
+    if (stats != nullptr) {
+      ++stats;
+    }
+    PushStride(stride, features, stats);
+    stride += kStrideSize;
+  }
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::ComputeChannels(
+    const int16_t* window, uint32_t* channels) {
+  const int16_t max_abs =
+      FrontendApplyWindow(window, Tables::kWindow.values, kWindowSize,
+                          kFrontendWindowShift, fft_input_);
+  WindowedToChannels(max_abs, channels);
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::WindowedToChannels(
+    int16_t max_abs, uint32_t* channels) {
+  // The square root stage shifts the result back down.
+  const int scale_bits =
+      FrontendFftAutoScale(fft_input_, kWindowSize, max_abs);
+  memset(fft_input_ + kWindowSize, 0,
+         (Geometry::kFftLength - kWindowSize) * sizeof(int16_t));
+
+  FrontendRfft<Geometry::kFftLength>(fft_input_, fft_scratch_, spectrum_);
+  FrontendSpectrumToEnergy(spectrum_, Tables::kSpectrumStart,
+                           Tables::kSpectrumEnd, energy_);
+  FrontendFilterbankAccumulate(trimmed_filterbank_, energy_, filterbank_);
+  FrontendFilterbankSqrt(filterbank_ + 1, kChannelCount, scale_bits,
+                         channels);
+}
+
+template <typename Geometry, FrontendFeatureType FeatureType, int FeatureCount>
+void BasicAudioFrontend<Geometry, FeatureType, FeatureCount>::ChannelsToFeatures(
+    uint32_t* channels, int8_t* features, FrontendSliceStats* stats) {
+  if (stats != nullptr) {
+    FrontendSliceStatistics(channels, noise_estimate_, kNoiseSmoothingBits,
+                            kChannelCount, stats);
+  }
+
+  // Spectral subtraction, smoothing odd channels a bit faster.
+  for (int i = 0; i < kChannelCount; ++i) {
+    uint32_t smoothing;
+    uint32_t one_minus_smoothing;
+    if ((i & 1) == 0) {
+      smoothing = kNoiseSmoothing;
+      one_minus_smoothing = kNoiseOneMinusSmoothing;
+    } else {
+      smoothing = kNoiseAlternateSmoothing;
+      one_minus_smoothing = kNoiseAlternateOneMinusSmoothing;
+    }
+    const uint32_t signal_scaled_up = channels[i] << kNoiseSmoothingBits;
+    noise_estimate_[i] =
+        ((static_cast<uint64_t>(signal_scaled_up) * smoothing) +
+         (static_cast<uint64_t>(noise_estimate_[i]) * one_minus_smoothing)) >>
+        kSpectralSubtractionBits;
+    uint32_t estimate_scaled_up = noise_estimate_[i];
+    if (estimate_scaled_up > signal_scaled_up) {
+      estimate_scaled_up = signal_scaled_up;
+    }
+    const uint32_t floor =
+        (static_cast<uint64_t>(channels[i]) * kMinSignalRemaining) >>
+        kSpectralSubtractionBits;
+    const uint32_t subtracted =
+        (signal_scaled_up - estimate_scaled_up) >> kNoiseSmoothingBits;
+    channels[i] = subtracted > floor ? subtracted : floor;
+  }
+
+#if MICRO_FEATURES_PCAN
+  FrontendPcan(kFrontendPcanGainLut.values, kPcanSnrShift, noise_estimate_,
+               channels, kChannelCount);
+#endif
+  FrontendFilterbankLog(channels, kChannelCount, kLogOutputScale,
+                        kLogInputCorrectionBits, log_);
+
+  if constexpr (FeatureType == FrontendFeatureType::kMfcc) {
+    FrontendDct(log_, kChannelCount, DctTables::kDct.values,
+                kFrontendDctBits, kFeatureCount, kMfccOutputShift, features);
+  } else {
+    for (int i = 0; i < kFeatureCount; ++i) {
+      int32_t value = (log_[i] * kInt8ScaleNumerator + kInt8ScaleRounding) /
+                          kInt8ScaleDenominator -
+                      128;
+      if (value > 127) {
+        value = 127;
+      } else if (value < -128) {
+        value = -128;
+      }
+      features[i] = value;
+    }
+  }
+}
+
+// The configurations the host frontend benchmark compares, 40 or 32 mel
+// channels as log mel features or 13 MFCCs, and the one of
+// micro_model_settings.h if it isn't among them. The linker drops any that go
+// unused.
+template <int NumChannels>
+using BenchmarkGeometry = FrontendGeometry<kAudioSampleFrequency,
+                                           kFeatureDurationMs,
+                                           kFeatureStrideMs, NumChannels>;
+template class BasicAudioFrontend<BenchmarkGeometry<40>>;
+template class BasicAudioFrontend<BenchmarkGeometry<40>,
+                                  FrontendFeatureType::kMfcc, 13>;
+template class BasicAudioFrontend<BenchmarkGeometry<32>>;
+template class BasicAudioFrontend<BenchmarkGeometry<32>,
+                                  FrontendFeatureType::kMfcc, 13>;
+#if !((MICRO_FEATURES_CHANNEL_COUNT == 40 ||             \
+       MICRO_FEATURES_CHANNEL_COUNT == 32) &&            \
+      (MICRO_FEATURES_TYPE == MICRO_FEATURES_LOG_MEL ||  \
+       MICRO_FEATURES_MFCC_COUNT == 13))
+template class BasicAudioFrontend<DefaultFrontendGeometry,
+                                  kDefaultFrontendFeatureType, kFeatureSize>;
+#endif
@@ -0,0 +1,158 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_FRONTEND_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_FRONTEND_H_
+
+#include <cstdint>
+
+#include "audio_frontend_tables.h"
+#include "frontend_stages.h"
+#include "micro_model_settings.h"
+
+// Native fixed-point version of the audio preprocessor model. It runs the same
+// stages as g_audio_preprocessor_int8_tflite: Hann window, FFT auto scale,
+// real FFT, energy, mel filterbank, square root, spectral
+// subtraction, PCAN auto gain control and log, followed by the conversion to
+// int8. Every stage does the same integer arithmetic as the matching signal
+// kernel, so the features are bit-exact with the interpreter's, but none of the
+// interpreter's tensor copies, glue ops or arena are needed.
+// tools/frontend_reference_test.cc checks that on the test clips, against the
+// model run with both the stock and the signal_kernels.h kernels.
+//
+// The noise estimate carries over from one window to the next, so windows
+// must be fed in the order they were recorded.
+//
+// Consecutive windows overlap by kOverlapCount samples. The frontend keeps the
+// end of the last window it saw, so once it has one, each following window
+// can be fed as just its kStrideSize new samples with PushStride.
+//
+// The window, stride, FFT and channel counts all come from Geometry, a
+// FrontendGeometry, and its tables from FrontendTables<Geometry>, so every
+// loop has a fixed trip count. FeatureType picks what comes out of the log
+// channels: the channels themselves, or FeatureCount MFCCs. Only 40 channels
+// of log mel features match the preprocessor model.
+// audio_frontend.cc instantiates the configurations in use, and AudioFrontend
+// is the one for micro_model_settings.h.
+enum class FrontendFeatureType {
+  kLogMel,
+  kMfcc,
+};
+
+template <typename Geometry,
+          FrontendFeatureType FeatureType = FrontendFeatureType::kLogMel,
+          int FeatureCount = Geometry::kNumChannels>
+class BasicAudioFrontend {
+ public:
+  static constexpr int kWindowSize = Geometry::kWindowSize;
+  static constexpr int kStrideSize = Geometry::kStrideSize;
+  static constexpr int kChannelCount = Geometry::kNumChannels;
+  static constexpr int kFeatureCount = FeatureCount;
+  static constexpr int kOverlapCount = kWindowSize - kStrideSize;
+
+  static_assert(kStrideSize <= kWindowSize,
+                "Windows must not leave gaps between them");
+  static_assert(FeatureType != FrontendFeatureType::kLogMel ||
+                    kFeatureCount == kChannelCount,
+                "Log mel features are one per channel");
+
+  BasicAudioFrontend();
+
+  // Forgets the noise estimate and the overlap, as if no audio had been seen
+  // yet.
+  void Reset();
+
+  // Forgets only the overlap, for when the next audio doesn't follow on from
+  // the last window, but the noise estimate still applies.
+  void DropOverlap();
+
+  // Turns kWindowSize samples of audio into kFeatureCount features. The
+  // methods that compute features also fill in stats, if given, for each
+  // slice they compute.
+  void ProcessWindow(const int16_t* window, int8_t* features,
+                     FrontendSliceStats* stats = nullptr);
+
+  // Turns the kStrideSize samples of audio that follow the last window or
+  // stride into the features of the window they end. Returns false, leaving
+  // features untouched, if there was no previous audio to complete the
+  // window with. The samples are then kept as the overlap if they cover it.
+  bool PushStride(const int16_t* samples, int8_t* features,
+                  FrontendSliceStats* stats = nullptr);
+
+  // Turns slice_count consecutive windows, kStrideSize samples apart, into
+  // slice_count rows of kFeatureCount features. audio must hold
+  // (slice_count - 1) * kStrideSize + kWindowSize samples. Only the first
+  // window is read whole, the rest are streamed in.
+  void ProcessSlices(const int16_t* audio, int slice_count, int8_t* features,
+                     FrontendSliceStats* stats = nullptr);
+
+  // ProcessWindow in two halves, so that windows can be spread over several
+  // instances. ComputeChannels runs the stages up to the filterbank square
+  // root, which depend on nothing but the window, so any instance can run it
+  // on any window in any order. ChannelsToFeatures runs the rest on the
+  // result, in place, and carries the noise estimate on, so it must see the
+  // windows in order on the instance that keeps the state. Neither touches
+  // the overlap: call KeepOverlap with the last window before PushStride.
+  // ChannelsToFeatures leaves the clipped samples of stats to the caller.
+  void ComputeChannels(const int16_t* window, uint32_t* channels);
+  void ChannelsToFeatures(uint32_t* channels, int8_t* features,
+                          FrontendSliceStats* stats = nullptr);
+
+  // Keeps the end of window as the overlap for the next PushStride.
+  void KeepOverlap(const int16_t* window);
+
+ private:
+  // Runs the stateless stages after the window on fft_input_.
+  void WindowedToChannels(int16_t max_abs, uint32_t* channels);
+
+  using Tables = FrontendTables<Geometry>;
+  using DctTables = FrontendDctTables<kChannelCount, kFeatureCount>;
+
+  // The filterbank tables with the zero weights trimmed off each channel.
+  int16_t channel_frequency_starts_[kChannelCount + 1];
+  int16_t channel_weight_starts_[kChannelCount + 1];
+  int16_t channel_widths_[kChannelCount + 1];
+  FrontendFilterbank trimmed_filterbank_;
+
+  // Noise estimate of the spectral subtraction stage, per channel.
+  uint32_t noise_estimate_[kChannelCount];
+
+  // The last kOverlapCount samples seen, if has_overlap_.
+  int16_t overlap_[kOverlapCount];
+  bool has_overlap_;
+
+  // Scratch space for the stages, kept here rather than on the stack.
+  int16_t fft_input_[Geometry::kFftLength];
+  FrontendComplex fft_scratch_[Geometry::kFftLength / 2];
+  FrontendComplex spectrum_[Geometry::kFftBins];
+  uint32_t energy_[Geometry::kFftBins];
+  uint64_t filterbank_[kChannelCount + 1];
+  uint32_t channels_[kChannelCount];
+  int16_t log_[kChannelCount];
+};
+
+#if MICRO_FEATURES_TYPE == MICRO_FEATURES_MFCC
+constexpr FrontendFeatureType kDefaultFrontendFeatureType =
+    FrontendFeatureType::kMfcc;
+#else
+constexpr FrontendFeatureType kDefaultFrontendFeatureType =
+    FrontendFeatureType::kLogMel;
+#endif
+
+using AudioFrontend = BasicAudioFrontend<DefaultFrontendGeometry,
+                                         kDefaultFrontendFeatureType,
+                                         kFeatureSize>;
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_FRONTEND_H_
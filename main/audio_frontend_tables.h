@@ -0,0 +1,426 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_FRONTEND_TABLES_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_FRONTEND_TABLES_H_
+
+#include <cstdint>
+
+#include "micro_model_settings.h"
+
+// Constant tables of the audio frontend, computed at compile time from the
+// feature geometry in the same way the signal library's Python ops compute
+// the ones baked into g_audio_preprocessor_int8_tflite. With the settings in
+// micro_model_settings.h they come out identical to the model's tensors.
+//
+// The tables are static constexpr members of class templates, so each
+// geometry gets its own set, placed in flash (.rodata) like any other const
+// data. Mark a use with DRAM_ATTR or copy it to move it to internal RAM.
+
+// Fixed parameters of the preprocessor model that don't depend on geometry.
+constexpr int kFrontendWindowShift = 12;
+constexpr double kFrontendLowerBandLimit = 125.0;
+constexpr double kFrontendUpperBandLimit = 7500.0;
+constexpr int kFrontendFilterbankWeightBits = 12;
+constexpr double kFrontendPcanStrength = 0.95;
+constexpr double kFrontendPcanOffset = 80.0;
+constexpr int kFrontendPcanGainBits = 21;
+// The noise estimate's 10 smoothing bits, less the 3 input correction bits.
+constexpr int kFrontendPcanInputBits = 7;
+constexpr int kFrontendPcanGainLutSize = 125;
+constexpr int kFrontendLogSegmentsLog2 = 7;
+// Fraction bits of the DCT matrix used for MFCCs.
+constexpr int kFrontendDctBits = 15;
+
+namespace frontend_tables {
+
+// Just enough double precision math to build the tables in constant
+// expressions, since <cmath> isn't constexpr. Accurate to a few ulp, far
+// below what rounding to 16 bits can see.
+constexpr double kPi = 3.14159265358979323846264338327950288;
+constexpr double kLn2 = 0.693147180559945309417232121458176568;
+
+constexpr double Floor(double x) {
+  const double truncated = static_cast<double>(static_cast<int64_t>(x));
+  return (truncated > x) ? truncated - 1 : truncated;
+}
+
+constexpr double Exp(double x) {
+  const int64_t k = static_cast<int64_t>(Floor(x / kLn2 + 0.5));
+  const double r = x - k * kLn2;
+  double term = 1;
+  double sum = 1;
+  for (int n = 1; n < 30; ++n) {
+    term *= r / n;
+    sum += term;
+  }
+  for (int64_t i = 0; i < k; ++i) {
+    sum *= 2;
+  }
+  for (int64_t i = 0; i > k; --i) {
+    sum /= 2;
+  }
+  return sum;
+}
+
+constexpr double Log(double x) {
+  int exponent = 0;
+  while (x > 1.4142135623730951) {
+    x /= 2;
+    ++exponent;
+  }
+  while (x < 0.7071067811865476) {
+    x *= 2;
+    --exponent;
+  }
+  // log(x) = 2 atanh((x - 1) / (x + 1)).
+  const double y = (x - 1) / (x + 1);
+  double power = y;
+  double sum = 0;
+  for (int n = 1; n < 60; n += 2) {
+    sum += power / n;
+    power *= y * y;
+  }
+  return 2 * sum + exponent * kLn2;
+}
+
+constexpr double Pow(double x, double y) { return Exp(y * Log(x)); }
+
+constexpr double Sqrt(double x) {
+  double root = (x > 1) ? x : 1;
+  for (int i = 0; i < 64; ++i) {
+    root = 0.5 * (root + x / root);
+  }
+  return root;
+}
+
+constexpr double Cos(double x) {
+  x -= 2 * kPi * Floor((x + kPi) / (2 * kPi));
+  double term = 1;
+  double sum = 1;
+  for (int n = 1; n < 30; ++n) {
+    term *= -x * x / ((2 * n - 1) * (2 * n));
+    sum += term;
+  }
+  return sum;
+}
+
+// Rounds halves to even, like numpy.round.
+constexpr double RoundHalfEven(double x) {
+  const double rounded = Floor(x + 0.5);
+  if (rounded - x == 0.5 && static_cast<int64_t>(rounded) % 2 != 0) {
+    return rounded - 1;
+  }
+  return rounded;
+}
+
+constexpr int NextPowerOfTwo(int x) {
+  int power = 1;
+  while (power < x) {
+    power *= 2;
+  }
+  return power;
+}
+
+constexpr double FreqToMel(double freq) {
+  return 1127.0 * Log(1.0 + freq / 700.0);
+}
+
+}  // namespace frontend_tables
+
+// Sizes of a frontend for the given sample rate, window and stride lengths
+// and number of mel channels.
+template <int SampleRate, int DurationMs, int StrideMs, int NumChannels>
+struct FrontendGeometry {
+  static constexpr int kSampleRate = SampleRate;
+  static constexpr int kWindowSize = DurationMs * SampleRate / 1000;
+  static constexpr int kStrideSize = StrideMs * SampleRate / 1000;
+  static constexpr int kNumChannels = NumChannels;
+  static constexpr int kFftLength =
+      frontend_tables::NextPowerOfTwo(kWindowSize);
+  static constexpr int kFftBins = kFftLength / 2 + 1;
+};
+
+// The geometry of micro_model_settings.h, which the models were trained on.
+using DefaultFrontendGeometry =
+    FrontendGeometry<kAudioSampleFrequency, kFeatureDurationMs,
+                     kFeatureStrideMs, kFilterbankChannelCount>;
+
+namespace frontend_tables {
+
+// Each channel's filterbank weights start on an even bin and are padded out
+// to a multiple of this many weights.
+constexpr int kFilterbankIndexAlignment = 2;
+constexpr int kFilterbankChannelBlockSize = 4;
+
+// Where each channel of a mel filterbank sits in the spectrum and in the
+// weight tables. Channel 0 only collects the unweights of the first bins.
+template <int NumChannels>
+struct FilterbankLayout {
+  static constexpr int kChannels = NumChannels + 1;
+  double center_mels[kChannels] = {};
+  int16_t actual_starts[kChannels] = {};
+  int16_t actual_widths[kChannels] = {};
+  int16_t frequency_starts[kChannels] = {};
+  int16_t weight_starts[kChannels] = {};
+  int16_t widths[kChannels] = {};
+  double hz_per_bin = 0;
+  int spectrum_start = 0;
+  int spectrum_end = 0;
+  int weight_count = 0;
+};
+
+template <int NumChannels>
+constexpr FilterbankLayout<NumChannels> ComputeFilterbankLayout(
+    int sample_rate, int fft_length) {
+  FilterbankLayout<NumChannels> layout;
+  constexpr int kChannels = FilterbankLayout<NumChannels>::kChannels;
+  const double mel_low = FreqToMel(kFrontendLowerBandLimit);
+  const double mel_spacing =
+      (FreqToMel(kFrontendUpperBandLimit) - mel_low) / kChannels;
+  for (int i = 0; i < kChannels; ++i) {
+    layout.center_mels[i] = mel_low + mel_spacing * (i + 1);
+  }
+
+  // Always exclude DC.
+  const int spectrum_size = fft_length / 2 + 1;
+  layout.hz_per_bin = 0.5 * sample_rate / (spectrum_size - 1);
+  layout.spectrum_start = static_cast<int>(
+      1.5 + kFrontendLowerBandLimit / layout.hz_per_bin);
+
+  // Channels that get no bins at all are pointed at a block of zero weights
+  // at the start of the tables.
+  int channel_start = layout.spectrum_start;
+  int weight_index = 0;
+  bool needs_zeros = false;
+  for (int chan = 0; chan < kChannels; ++chan) {
+    int freq_index = channel_start;
+    while (FreqToMel(freq_index * layout.hz_per_bin) <=
+           layout.center_mels[chan]) {
+      ++freq_index;
+    }
+    const int width = freq_index - channel_start;
+    layout.actual_starts[chan] = channel_start;
+    layout.actual_widths[chan] = width;
+    if (width == 0) {
+      layout.frequency_starts[chan] = 0;
+      layout.weight_starts[chan] = 0;
+      layout.widths[chan] = kFilterbankChannelBlockSize;
+      if (!needs_zeros) {
+        needs_zeros = true;
+        for (int j = 0; j < chan; ++j) {
+          layout.weight_starts[j] += kFilterbankChannelBlockSize;
+        }
+        weight_index += kFilterbankChannelBlockSize;
+      }
+    } else {
+      const int aligned_start = (channel_start / kFilterbankIndexAlignment) *
+                                kFilterbankIndexAlignment;
+      const int aligned_width = channel_start - aligned_start + width;
+      const int padded_width =
+          ((aligned_width - 1) / kFilterbankChannelBlockSize + 1) *
+          kFilterbankChannelBlockSize;
+      layout.frequency_starts[chan] = aligned_start;
+      layout.weight_starts[chan] = weight_index;
+      layout.widths[chan] = padded_width;
+      weight_index += padded_width;
+    }
+    channel_start = freq_index;
+  }
+  layout.weight_count = weight_index;
+  for (int chan = 0; chan < kChannels; ++chan) {
+    const int end = layout.actual_starts[chan] + layout.actual_widths[chan];
+    if (end > layout.spectrum_end) {
+      layout.spectrum_end = end;
+    }
+  }
+  return layout;
+}
+
+template <typename Geometry>
+constexpr FilterbankLayout<Geometry::kNumChannels> kFilterbankLayout =
+    ComputeFilterbankLayout<Geometry::kNumChannels>(Geometry::kSampleRate,
+                                                    Geometry::kFftLength);
+
+template <int Size>
+struct Int16Table {
+  int16_t values[Size] = {};
+};
+
+template <int Size>
+struct Uint16Table {
+  uint16_t values[Size] = {};
+};
+
+template <int Size>
+constexpr Int16Table<Size> ToTable(const int16_t (&values)[Size]) {
+  Int16Table<Size> table;
+  for (int i = 0; i < Size; ++i) {
+    table.values[i] = values[i];
+  }
+  return table;
+}
+
+// Hann window, scaled by 1 << kFrontendWindowShift.
+template <int Size>
+constexpr Int16Table<Size> ComputeWindow() {
+  Int16Table<Size> table;
+  for (int i = 0; i < Size; ++i) {
+    const double weight = 0.5 - 0.5 * Cos(2 * kPi / Size * (i + 0.5));
+    table.values[i] = static_cast<int16_t>(
+        RoundHalfEven(weight * (1 << kFrontendWindowShift)));
+  }
+  return table;
+}
+
+// Triangular mel weights, or one minus them when unweights is set, in
+// 1 << kFrontendFilterbankWeightBits units, truncated.
+template <int NumChannels, int WeightCount>
+constexpr Int16Table<WeightCount> ComputeFilterbankWeights(
+    const FilterbankLayout<NumChannels>& layout, bool unweights) {
+  Int16Table<WeightCount> table;
+  const double mel_low = FreqToMel(kFrontendLowerBandLimit);
+  for (int chan = 0; chan < FilterbankLayout<NumChannels>::kChannels; ++chan) {
+    const double center = layout.center_mels[chan];
+    const double previous = (chan == 0) ? mel_low : layout.center_mels[chan - 1];
+    const int offset = layout.actual_starts[chan] +
+                       layout.weight_starts[chan] -
+                       layout.frequency_starts[chan];
+    for (int j = 0; j < layout.actual_widths[chan]; ++j) {
+      const int frequency = layout.actual_starts[chan] + j;
+      double weight = (center - FreqToMel(frequency * layout.hz_per_bin)) /
+                      (center - previous);
+      if (unweights) {
+        weight = 1.0 - weight;
+      }
+      table.values[offset + j] =
+          static_cast<int16_t>(weight * (1 << kFrontendFilterbankWeightBits));
+    }
+  }
+  return table;
+}
+
+constexpr int16_t PcanGain(uint32_t x) {
+  const double gain =
+      (1 << kFrontendPcanGainBits) *
+      Pow(static_cast<double>(x) / (1 << kFrontendPcanInputBits) +
+              kFrontendPcanOffset,
+          -kFrontendPcanStrength);
+  return (gain > INT16_MAX) ? INT16_MAX : static_cast<int16_t>(gain + 0.5);
+}
+
+// Piecewise quadratic gain curve of the PCAN auto gain control, indexed by
+// the position of the most significant bit of the noise estimate.
+constexpr Int16Table<kFrontendPcanGainLutSize> ComputePcanGainLut() {
+  constexpr int kIntervals = 32;
+  Int16Table<kFrontendPcanGainLutSize> table;
+  table.values[0] = PcanGain(0);
+  table.values[1] = PcanGain(1);
+  for (int interval = 2; interval <= kIntervals; ++interval) {
+    const uint32_t x0 = 1u << (interval - 1);
+    const uint32_t x1 = x0 + (x0 >> 1);
+    const uint32_t x2 = (interval == kIntervals) ? x0 + (x0 - 1) : 2 * x0;
+    const int32_t y0 = PcanGain(x0);
+    const int32_t diff1 = PcanGain(x1) - y0;
+    const int32_t diff2 = PcanGain(x2) - y0;
+    const int32_t a1 = 4 * diff1 - diff2;
+    const int32_t a2 = diff2 - a1;
+    table.values[4 * interval - 6] = y0;
+    table.values[4 * interval - 5] = a1;
+    table.values[4 * interval - 4] = a2;
+  }
+  return table;
+}
+
+// (log2(1 + x) - x) * 65536 sampled at 128 points in [0, 1].
+constexpr Uint16Table<(1 << kFrontendLogSegmentsLog2) + 1> ComputeLogLut() {
+  constexpr int kSegments = 1 << kFrontendLogSegmentsLog2;
+  Uint16Table<kSegments + 1> table;
+  for (int i = 0; i <= kSegments; ++i) {
+    const double x = static_cast<double>(i) / kSegments;
+    table.values[i] = static_cast<uint16_t>(
+        RoundHalfEven((Log(1.0 + x) / kLn2 - x) * 65536));
+  }
+  return table;
+}
+
+// Orthonormal DCT-II from NumChannels log channels to the first
+// NumCoefficients cepstral coefficients, row by row, scaled by
+// 1 << kFrontendDctBits.
+template <int NumChannels, int NumCoefficients>
+constexpr Int16Table<NumChannels * NumCoefficients> ComputeDct() {
+  Int16Table<NumChannels * NumCoefficients> table;
+  for (int k = 0; k < NumCoefficients; ++k) {
+    const double scale = Sqrt(((k == 0) ? 1.0 : 2.0) / NumChannels);
+    for (int n = 0; n < NumChannels; ++n) {
+      const double weight = scale * Cos(kPi / NumChannels * (n + 0.5) * k);
+      table.values[k * NumChannels + n] = static_cast<int16_t>(
+          RoundHalfEven(weight * (1 << kFrontendDctBits)));
+    }
+  }
+  return table;
+}
+
+}  // namespace frontend_tables
+
+// Every table a frontend of the given geometry needs.
+template <typename Geometry>
+struct FrontendTables {
+  static constexpr int kSpectrumStart =
+      frontend_tables::kFilterbankLayout<Geometry>.spectrum_start;
+  static constexpr int kSpectrumEnd =
+      frontend_tables::kFilterbankLayout<Geometry>.spectrum_end;
+  static constexpr int kFilterbankWeightCount =
+      frontend_tables::kFilterbankLayout<Geometry>.weight_count;
+  static constexpr int kFilterbankChannels = Geometry::kNumChannels + 1;
+
+  static constexpr frontend_tables::Int16Table<Geometry::kWindowSize> kWindow =
+      frontend_tables::ComputeWindow<Geometry::kWindowSize>();
+  static constexpr frontend_tables::Int16Table<kFilterbankWeightCount>
+      kFilterbankWeights = frontend_tables::ComputeFilterbankWeights<
+          Geometry::kNumChannels, kFilterbankWeightCount>(
+          frontend_tables::kFilterbankLayout<Geometry>, false);
+  static constexpr frontend_tables::Int16Table<kFilterbankWeightCount>
+      kFilterbankUnweights = frontend_tables::ComputeFilterbankWeights<
+          Geometry::kNumChannels, kFilterbankWeightCount>(
+          frontend_tables::kFilterbankLayout<Geometry>, true);
+  static constexpr frontend_tables::Int16Table<kFilterbankChannels>
+      kChannelFrequencyStarts = frontend_tables::ToTable(
+          frontend_tables::kFilterbankLayout<Geometry>.frequency_starts);
+  static constexpr frontend_tables::Int16Table<kFilterbankChannels>
+      kChannelWeightStarts = frontend_tables::ToTable(
+          frontend_tables::kFilterbankLayout<Geometry>.weight_starts);
+  static constexpr frontend_tables::Int16Table<kFilterbankChannels>
+      kChannelWidths = frontend_tables::ToTable(
+          frontend_tables::kFilterbankLayout<Geometry>.widths);
+};
+
+// The DCT an MFCC frontend with NumCoefficients coefficients applies to its
+// NumChannels log channels.
+template <int NumChannels, int NumCoefficients>
+struct FrontendDctTables {
+  static_assert(NumCoefficients <= NumChannels,
+                "There are only as many coefficients as channels");
+  static constexpr frontend_tables::Int16Table<NumChannels * NumCoefficients>
+      kDct = frontend_tables::ComputeDct<NumChannels, NumCoefficients>();
+};
+
+// Tables that don't depend on the geometry.
+constexpr frontend_tables::Int16Table<kFrontendPcanGainLutSize>
+    kFrontendPcanGainLut = frontend_tables::ComputePcanGainLut();
+constexpr frontend_tables::Uint16Table<(1 << kFrontendLogSegmentsLog2) + 1>
+    kFrontendLogLut = frontend_tables::ComputeLogLut();
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_FRONTEND_TABLES_H_
@@ -0,0 +1,32 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "audio_gap_log.h"
+
+void AudioGapLog::Mark(int64_t sample) {
+  markers_[count_ % kMaxMarkers] = sample;
+  ++count_;
+}
+
+bool AudioGapLog::RangeHasGap(int64_t start_sample, int sample_count) const {
+  const int first = (count_ > kMaxMarkers) ? count_ - kMaxMarkers : 0;
+  for (int i = first; i < count_; ++i) {
+    const int64_t gap = markers_[i % kMaxMarkers];
+    if (gap > start_sample && gap < start_sample + sample_count) {
+      return true;
+    }
+  }
+  return false;
+}
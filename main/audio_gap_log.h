@@ -0,0 +1,44 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_GAP_LOG_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_GAP_LOG_H_
+
+#include <cstdint>
+
+// The sample indices at which the captured stream is not contiguous with the
+// sample before, kept as a small ring of the most recent ones. It does no
+// locking of its own: audio_provider.cc marks gaps from the capture task and
+// queries them from the model's, inside a critical section.
+class AudioGapLog {
+ public:
+  static constexpr int kMaxMarkers = 16;
+
+  AudioGapLog() : markers_(), count_(0) {}
+
+  // Records that audio was lost right before sample.
+  void Mark(int64_t sample);
+
+  // Returns true if one of the last kMaxMarkers gaps falls strictly inside
+  // the range, so that its samples come from two separate moments. A gap at
+  // the first sample, or right after the last, doesn't split the range.
+  bool RangeHasGap(int64_t start_sample, int sample_count) const;
+
+ private:
+  int64_t markers_[kMaxMarkers];
+  int count_;
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_GAP_LOG_H_
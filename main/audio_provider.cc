@@ -25,11 +25,13 @@ limitations under the License.
 // clang-format on
 
 #include "driver/i2s.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_spi_flash.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "freertos/task.h"
+#include "audio_gap_log.h"
 #include "ringbuf.h"
 #include "micro_model_settings.h"
 
@@ -43,25 +45,43 @@ using namespace std;
 static const char* TAG = "TF_LITE_AUDIO_PROVIDER";
 /* ringbuffer to hold the incoming audio data */
 ringbuf_t* g_audio_capture_buffer;
+/* PSRAM ringbuffer holding the last few seconds of audio */
+ringbuf_t* g_audio_history_buffer;
 volatile int32_t g_latest_audio_timestamp = 0;
-/* model requires 20ms new data from g_audio_capture_buffer and 10ms old data
- * each time , storing old data in the histrory buffer , {
- * history_samples_to_keep = 10 * 16 } */
-constexpr int32_t history_samples_to_keep =
-    ((kFeatureDurationMs - kFeatureStrideMs) *
-     (kAudioSampleFrequency / 1000));
-/* new samples to get each time from ringbuffer, { new_samples_to_get =  20 * 16
- * } */
-constexpr int32_t new_samples_to_get =
-    (kFeatureStrideMs * (kAudioSampleFrequency / 1000));
-
-const int32_t kAudioCaptureBufferSize = 40000;
+/* audio is addressed by sample index since recording started, and stored
+ * as 16-bit samples in the ring buffers */
+constexpr int32_t kSamplesPerMs = kAudioSampleFrequency / 1000;
+constexpr int32_t kBytesPerSample = sizeof(int16_t);
+
+/* The newest 500ms of audio live in internal SRAM, where the frontend reads
+ * every slice's window from, in place while it is recent enough. Everything
+ * captured is also appended in bulk to four seconds of history in PSRAM,
+ * which GetAudioSamplesAt serves any window from once it has left SRAM, for
+ * look-back and for a reader that falls more than 500ms behind. */
+const int32_t kAudioCaptureBufferSize = 16000;
+const int32_t kAudioHistoryBufferSize = 128000;
 const int32_t i2s_bytes_to_read = 3200;
+/* once the model is this far behind the microphone, skip ahead and keep only
+ * the newest kAudioBacklogKeepMs of unread audio */
+constexpr int32_t kMaxAudioBacklogMs = 300;
+constexpr int32_t kAudioBacklogKeepMs = 100;
+/* audio handed out in place must be at least this far from being
+ * overwritten. The next capture block, up to 100ms, can land at any moment,
+ * and the rest leaves the frontend longer than a whole batch of slices
+ * takes to use it. */
+constexpr int32_t kInPlaceMarginMs = 200;
+/* fault injection: when non-zero, every Nth I2S block is thrown away as if it
+ * had been lost, to exercise gap handling downstream */
+#ifndef AUDIO_GAP_FAULT_INJECTION_PERIOD
+#define AUDIO_GAP_FAULT_INJECTION_PERIOD 0
+#endif
 
 namespace {
 int16_t g_audio_output_buffer[kMaxAudioSampleSize * 32];
 bool g_is_audio_initialized = false;
-int16_t g_history_buffer[history_samples_to_keep];
+/* where the captured stream is not contiguous, guarded by g_gap_lock */
+AudioGapLog g_gap_log;
+portMUX_TYPE g_gap_lock = portMUX_INITIALIZER_UNLOCKED;
 
 #if !NO_I2S_SUPPORT
 uint8_t g_i2s_read_buffer[i2s_bytes_to_read] = {};
@@ -125,22 +145,42 @@ static void i2s_init(void) {
 }
 #endif
 
+/* records that audio was lost right before the next sample to be written */
+static void MarkAudioGap() {
+  const int64_t sample = rb_write_pos(g_audio_capture_buffer) / kBytesPerSample;
+  portENTER_CRITICAL(&g_gap_lock);
+  g_gap_log.Mark(sample);
+  portEXIT_CRITICAL(&g_gap_lock);
+}
+
 static void CaptureSamples(void* arg) {
 #if NO_I2S_SUPPORT
   ESP_LOGE(TAG, "i2s support not available on C3 chip for IDF < 4.4.0");
 #else
   size_t bytes_read = i2s_bytes_to_read;
+#if AUDIO_GAP_FAULT_INJECTION_PERIOD
+  int block_count = 0;
+#endif
   i2s_init();
   while (1) {
     /* read 100ms data at once from i2s */
     i2s_read(i2s_port, (void*)g_i2s_read_buffer, i2s_bytes_to_read,
              &bytes_read, pdMS_TO_TICKS(100));
+#if AUDIO_GAP_FAULT_INJECTION_PERIOD
+    if (++block_count % AUDIO_GAP_FAULT_INJECTION_PERIOD == 0) {
+      ESP_LOGW(TAG, "Injecting audio gap");
+      bytes_read = 0;
+    }
+#endif
 
     if (bytes_read <= 0) {
       ESP_LOGE(TAG, "Error in I2S read : %d", bytes_read);
+      MarkAudioGap();
     } else {
+      bool lost_audio = false;
       if (bytes_read < i2s_bytes_to_read) {
         ESP_LOGW(TAG, "Partial I2S read");
+        lost_audio = true;
       }
 #if CONFIG_IDF_TARGET_ESP32S3
       // rescale the data
@@ -149,20 +189,31 @@ static void CaptureSamples(void* arg) {
       }
       bytes_read = bytes_read / 2;
 #endif
-      /* write bytes read by i2s into ring buffer */
-      int bytes_written = rb_write(g_audio_capture_buffer,
-                                   (uint8_t*)g_i2s_read_buffer, bytes_read, pdMS_TO_TICKS(100));
+      /* append the block to the PSRAM history in one go, then to the SRAM
+       * ring. Neither write blocks: the oldest audio is dropped instead,
+       * and whatever falls out of SRAM is still in the history. */
+      rb_write_overwrite(g_audio_history_buffer,
+                         (uint8_t*)g_i2s_read_buffer, bytes_read);
+      int bytes_written = rb_write_overwrite(g_audio_capture_buffer,
+                                             (uint8_t*)g_i2s_read_buffer, bytes_read);
       if (bytes_written != bytes_read) {
         ESP_LOGI(TAG, "Could only write %d bytes out of %d", bytes_written, bytes_read);
       }
       /* update the timestamp (in ms) to let the model know that new data has
-       * arrived */
-      g_latest_audio_timestamp = g_latest_audio_timestamp +
-          ((1000 * (bytes_written / 2)) / kAudioSampleFrequency);
+       * arrived. It is derived from the stream position so that timestamps
+       * and sample indices always agree. */
+      g_latest_audio_timestamp = (rb_write_pos(g_audio_capture_buffer) /
+                                  kBytesPerSample) / kSamplesPerMs;
       if (bytes_written <= 0) {
         ESP_LOGE(TAG, "Could Not Write in Ring Buffer: %d ", bytes_written);
+        lost_audio = true;
       } else if (bytes_written < bytes_read) {
         ESP_LOGW(TAG, "Partial Write");
+        lost_audio = true;
+      }
+      /* whatever went missing sits between this block and the next one */
+      if (lost_audio) {
+        MarkAudioGap();
       }
     }
   }
@@ -171,11 +222,26 @@ static void CaptureSamples(void* arg) {
 }
 
 TfLiteStatus InitAudioRecording() {
-  g_audio_capture_buffer = rb_init("tf_ringbuffer", kAudioCaptureBufferSize);
+  /* the SRAM ring mirrors one feature window past its end, so that every
+   * window can be read without copying */
+  g_audio_capture_buffer = rb_init_mirrored(
+      "tf_ringbuffer", kAudioCaptureBufferSize,
+      kAudioSampleDurationCount * kBytesPerSample,
+      MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
   if (!g_audio_capture_buffer) {
     ESP_LOGE(TAG, "Error creating ring buffer");
     return kTfLiteError;
   }
+#if CONFIG_SPIRAM
+  g_audio_history_buffer = rb_init_caps("tf_history", kAudioHistoryBufferSize,
+                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+  g_audio_history_buffer = rb_init("tf_history", kAudioHistoryBufferSize);
+#endif
+  if (!g_audio_history_buffer) {
+    ESP_LOGE(TAG, "Error creating history ring buffer");
+    return kTfLiteError;
+  }
   /* create CaptureSamples Task which will get the i2s_data from mic and fill it
    * in the ring buffer */
   xTaskCreate(CaptureSamples, "CaptureSamples", 1024 * 4, NULL, 10, NULL);
@@ -206,8 +272,7 @@ TfLiteStatus GetAudioSamples1(int* audio_samples_size, int16_t** audio_samples)
   return kTfLiteOk;
 }
 
-TfLiteStatus GetAudioSamples(int start_ms, int duration_ms,
-                             int* audio_samples_size, int16_t** audio_samples) {
+static TfLiteStatus EnsureAudioInitialized() {
   if (!g_is_audio_initialized) {
     TfLiteStatus init_status = InitAudioRecording();
     if (init_status != kTfLiteOk) {
@@ -215,34 +280,131 @@ TfLiteStatus GetAudioSamples(int start_ms, int duration_ms,
     }
     g_is_audio_initialized = true;
   }
-  /* copy 160 samples (320 bytes) into output_buff from history */
-  memcpy((void*)(g_audio_output_buffer), (void*)(g_history_buffer),
-         history_samples_to_keep * sizeof(int16_t));
+  return kTfLiteOk;
+}
 
-  /* copy 320 samples (640 bytes) from rb at ( int16_t*(g_audio_output_buffer) +
-   * 160 ), first 160 samples (320 bytes) will be from history */
-  int bytes_read =
-      rb_read(g_audio_capture_buffer,
-              ((uint8_t*)(g_audio_output_buffer + history_samples_to_keep)),
-              new_samples_to_get * sizeof(int16_t), pdMS_TO_TICKS(200));
-  if (bytes_read < 0) {
-    ESP_LOGE(TAG, " Model Could not read data from Ring Buffer");
-  } else if (bytes_read < new_samples_to_get * sizeof(int16_t)) {
-    ESP_LOGD(TAG, "RB FILLED RIGHT NOW IS %d",
-             rb_filled(g_audio_capture_buffer));
-    ESP_LOGD(TAG, " Partial Read of Data by Model ");
-    ESP_LOGV(TAG, " Could only read %d bytes when required %d bytes ",
-             bytes_read, (int) (new_samples_to_get * sizeof(int16_t)));
+AudioRetrievalStatus GetAudioSamplesAt(int64_t start_sample, int sample_count,
+                                       int16_t* dest) {
+  if (EnsureAudioInitialized() != kTfLiteOk) {
+    return kAudioNotCaptured;
+  }
+  /* there's no audio before recording started, treat it as silence */
+  if (start_sample < 0) {
+    const int silent = (-start_sample < sample_count) ? -start_sample : sample_count;
+    memset(dest, 0, silent * kBytesPerSample);
+    dest += silent;
+    sample_count -= silent;
+    start_sample = 0;
+    if (sample_count == 0) {
+      return kAudioOk;
+    }
   }
 
-  /* copy 320 bytes from output_buff into history */
-  memcpy((void*)(g_history_buffer),
-         (void*)(g_audio_output_buffer + new_samples_to_get),
-         history_samples_to_keep * sizeof(int16_t));
+  const int64_t pos = start_sample * kBytesPerSample;
+  const int len = sample_count * kBytesPerSample;
+  if (rb_wait_for_pos(g_audio_capture_buffer, pos + len, pdMS_TO_TICKS(200)) < 0) {
+    return kAudioNotCaptured;
+  }
+  /* the newest audio is served from SRAM, anything older from the PSRAM
+   * history */
+  int ret = rb_read_at(g_audio_capture_buffer, pos, (uint8_t*)dest, len);
+  if (ret == RB_EVICTED) {
+    ret = rb_read_at(g_audio_history_buffer, pos, (uint8_t*)dest, len);
+  }
+  if (ret == RB_EVICTED) {
+    return kAudioEvicted;
+  }
+  if (ret != len) {
+    return kAudioNotCaptured;
+  }
+  return kAudioOk;
+}
 
-  *audio_samples_size = kMaxAudioSampleSize;
-  *audio_samples = g_audio_output_buffer;
+int64_t OldestAudioSample() {
+  if (!g_is_audio_initialized) {
+    return 0;
+  }
+  const int64_t oldest = rb_write_pos(g_audio_history_buffer) - kAudioHistoryBufferSize;
+  return (oldest > 0 ? oldest : 0) / kBytesPerSample;
+}
+
+TfLiteStatus GetAudioSamples(int start_ms, int duration_ms,
+                             int* audio_samples_size, int16_t** audio_samples) {
+  const int sample_count = duration_ms * kSamplesPerMs;
+  if (sample_count > kMaxAudioSampleSize * 32) {
+    ESP_LOGE(TAG, "Requested %d ms of audio, more than the output buffer holds",
+             duration_ms);
+    return kTfLiteError;
+  }
+  const int64_t start_sample = (int64_t)start_ms * kSamplesPerMs;
+  if (EnsureAudioInitialized() != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  /* a window that is still in SRAM, and not about to be overwritten, is
+   * handed out in place. The mirrored tail of the ring keeps it contiguous
+   * even when it wraps around. */
+  const int64_t pos = start_sample * kBytesPerSample;
+  const int len = sample_count * kBytesPerSample;
+  const uint8_t* in_place = nullptr;
+  AudioRetrievalStatus status = kAudioOk;
+  if (start_sample >= 0 &&
+      rb_wait_for_pos(g_audio_capture_buffer, pos + len, pdMS_TO_TICKS(200)) == 0 &&
+      rb_peek_at(g_audio_capture_buffer, pos, len,
+                 kInPlaceMarginMs * kSamplesPerMs * kBytesPerSample,
+                 &in_place) == len) {
+    *audio_samples = (int16_t*)in_place;
+  } else {
+    status = GetAudioSamplesAt(start_sample, sample_count, g_audio_output_buffer);
+    *audio_samples = g_audio_output_buffer;
+  }
+  switch (status) {
+    case kAudioOk:
+      break;
+    case kAudioEvicted:
+      ESP_LOGE(TAG, "Audio at %d ms has already been evicted, oldest is %d ms",
+               start_ms, (int)(OldestAudioSample() / kSamplesPerMs));
+      return kTfLiteError;
+    case kAudioNotCaptured:
+      ESP_LOGE(TAG, "Audio at %d ms (+%d ms) hasn't been captured yet",
+               start_ms, duration_ms);
+      return kTfLiteError;
+  }
+  /* everything up to the end of this window has now been seen by the
+   * model, which is what BoundAudioLatency measures the backlog against */
+  const int64_t consumed = (start_sample + sample_count) * kBytesPerSample -
+                           rb_read_pos(g_audio_capture_buffer);
+  if (consumed > 0) {
+    rb_read(g_audio_capture_buffer, NULL, consumed, 0);
+  }
+  *audio_samples_size = sample_count;
   return kTfLiteOk;
 }
 
+bool AudioRangeHasGap(int64_t start_sample, int sample_count) {
+  portENTER_CRITICAL(&g_gap_lock);
+  const bool has_gap = g_gap_log.RangeHasGap(start_sample, sample_count);
+  portEXIT_CRITICAL(&g_gap_lock);
+  return has_gap;
+}
+
+int32_t BoundAudioLatency(int32_t* resume_ms) {
+  *resume_ms = 0;
+  if (!g_is_audio_initialized) {
+    return 0;
+  }
+  const int64_t backlog = rb_filled(g_audio_capture_buffer);
+  if (backlog <= kMaxAudioBacklogMs * kSamplesPerMs * kBytesPerSample) {
+    return 0;
+  }
+  const int skipped = rb_skip_to_latest(
+      g_audio_capture_buffer, kAudioBacklogKeepMs * kSamplesPerMs * kBytesPerSample);
+  if (skipped <= 0) {
+    return 0;
+  }
+  *resume_ms = (rb_read_pos(g_audio_capture_buffer) / kBytesPerSample) / kSamplesPerMs;
+  ESP_LOGW(TAG, "Model fell %d ms behind, skipping to %d ms",
+           (int)(backlog / kBytesPerSample / kSamplesPerMs), *resume_ms);
+  return (skipped / kBytesPerSample) / kSamplesPerMs;
+}
+
 int32_t LatestAudioTimestamp() { return g_latest_audio_timestamp; }
@@ -28,11 +28,54 @@ limitations under the License.
 // The reference implementation can have no platform-specific dependencies, so
 // it just returns an array filled with zeros. For real applications, you should
 // ensure there's a specialized implementation that accesses hardware APIs.
+// This implementation keeps the last few seconds of audio and returns exactly
+// the samples in [start_ms, start_ms + duration_ms), with time zero being the
+// moment recording started. Audio before time zero reads as silence. It fails
+// if the range has already been evicted or hasn't been captured within 200ms.
+// Windows of up to one feature window among the newest 300ms of audio in the
+// SRAM ring are returned as a pointer into the ring rather than copied. The
+// capture task overwrites them once it is 500ms past their start, so they
+// are only handed out with at least 200ms of capture to go before that,
+// which is how long they can be relied on. Older audio is always copied.
 TfLiteStatus GetAudioSamples(int start_ms, int duration_ms,
                              int* audio_samples_size, int16_t** audio_samples);
 
+// Outcome of fetching audio by sample index.
+enum AudioRetrievalStatus {
+  kAudioOk,
+  // The range is older than the retained history.
+  kAudioEvicted,
+  // The range extends past the newest captured sample.
+  kAudioNotCaptured,
+};
+
+// Copies sample_count samples starting at sample index start_sample (counted
+// from the start of recording) into dest. Unlike GetAudioSamples this doesn't
+// touch any shared buffer, so callers may fetch windows in any order and from
+// several tasks at once.
+AudioRetrievalStatus GetAudioSamplesAt(int64_t start_sample, int sample_count,
+                                       int16_t* dest);
+
+// Returns the index of the oldest sample that GetAudioSamplesAt can still
+// return.
+int64_t OldestAudioSample();
+
+// Returns true if audio was lost somewhere inside the given range, for example
+// because of a partial I2S read, so its samples are spliced together from two
+// separate moments. Capture records these discontinuities as it goes.
+bool AudioRangeHasGap(int64_t start_sample, int sample_count);
+
 TfLiteStatus GetAudioSamples1(int* audio_samples_size, int16_t** audio_samples);
 
+// Bounds how far the consumer of GetAudioSamples can lag behind the
+// microphone. Audio counts as consumed once a GetAudioSamples window has
+// reached it. If more than 300ms is still unconsumed, everything but the
+// newest 100ms is skipped, the timestamp of the oldest audio that was kept is
+// stored in resume_ms, and the number of milliseconds skipped is returned.
+// Returns zero and leaves resume_ms at zero when nothing was skipped. Callers
+// should not combine audio from before resume_ms with audio after it.
+int32_t BoundAudioLatency(int32_t* resume_ms);
+
 // Returns the time that audio data was last captured in milliseconds. There's
 // no contract about what time zero represents, the accuracy, or the granularity
 // of the result. Subsequent calls will generally not return a lower value, but
@@ -0,0 +1,378 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "benchmarks.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "audio_frontend.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "micro_features_generator.h"
+#include "micro_model_settings.h"
+#include "ringbuf.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+extern const uint8_t yes_1000ms_start[] asm("_binary_yes_1000ms_wav_start");
+extern const uint8_t no_1000ms_start[] asm("_binary_no_1000ms_wav_start");
+extern const uint8_t noise_1000ms_start[] asm("_binary_noise_1000ms_wav_start");
+extern const uint8_t silence_1000ms_start[] asm(
+    "_binary_silence_1000ms_wav_start");
+
+namespace {
+
+constexpr int kBenchmarkIterations = 500;
+// Bytes of new audio per feature stride, and bytes in one feature window.
+constexpr int kStrideBytes =
+    kFeatureStrideMs * (kAudioSampleFrequency / 1000) * sizeof(int16_t);
+constexpr int kWindowBytes =
+    kFeatureDurationMs * (kAudioSampleFrequency / 1000) * sizeof(int16_t);
+// Same sizes as the audio provider uses.
+constexpr int kFlatBufferSize = 40000;
+constexpr int kHotBufferSize = 16000;
+constexpr int kHistoryBufferSize = 128000;
+// How far back a look-back read reaches into the history.
+constexpr int kLookBackBytes = 64000;
+
+uint8_t g_block[kStrideBytes];
+uint8_t g_window[kWindowBytes];
+
+// One second clips from the test data, past their 44 byte WAV headers.
+constexpr int kWavHeaderBytes = 44;
+constexpr int kClipSampleCount = kAudioSampleFrequency;
+struct TestClip {
+  const char* name;
+  const uint8_t* wav;
+};
+const TestClip kTestClips[] = {
+    {"yes", yes_1000ms_start},
+    {"no", no_1000ms_start},
+    {"noise", noise_1000ms_start},
+    {"silence", silence_1000ms_start},
+};
+
+Features g_reference_features;
+Features g_native_features;
+// Staging for one slice at a time, as PopulateFeatureData used to have.
+Features g_slice_features;
+// Spectrogram and model input for the spectrogram update benchmark.
+int8_t g_spectrogram[kFeatureElementCount];
+int8_t g_model_input[kFeatureElementCount];
+
+// Streams audio into `writes` stride by stride, timing a read of the newest
+// window from `reader` after every stride, and returns the mean cycles per
+// read. `back` moves the read further into the past.
+unsigned TimeWindowReads(ringbuf_t* reader, ringbuf_t* const* writes,
+                         int write_count, int back) {
+  uint64_t total_cycles = 0;
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    for (int n = 0; n < kStrideBytes; ++n) {
+      g_block[n] = static_cast<uint8_t>(i + n);
+    }
+    for (int w = 0; w < write_count; ++w) {
+      rb_write_overwrite(writes[w], g_block, kStrideBytes);
+    }
+    const int64_t pos = rb_write_pos(reader) - kWindowBytes - back;
+    const uint32_t start = esp_cpu_get_cycle_count();
+    rb_read_at(reader, pos, g_window, kWindowBytes);
+    total_cycles += esp_cpu_get_cycle_count() - start;
+  }
+  return static_cast<unsigned>(total_cycles / kBenchmarkIterations);
+}
+
+// Fills a ring so the timed reads never hit a partially written buffer.
+void Prefill(ringbuf_t* rb, int size) {
+  for (int i = 0; i < size; i += kStrideBytes) {
+    rb_write_overwrite(rb, g_block, kStrideBytes);
+  }
+}
+
+// Counts the features that differ between a and b.
+int CountMismatches(const Features& a, const Features& b) {
+  int mismatches = 0;
+  for (int i = 0; i < kFeatureCount; ++i) {
+    for (int j = 0; j < kFeatureSize; ++j) {
+      if (a[i][j] != b[i][j]) {
+        ++mismatches;
+      }
+    }
+  }
+  return mismatches;
+}
+
+}  // namespace
+
+uint32_t OpProfiler::BeginEvent(const char* tag) {
+  int index = 0;
+  while (index < tag_count_ && strcmp(tags_[index], tag) != 0) {
+    ++index;
+  }
+  if (index == tag_count_) {
+    if (tag_count_ == kMaxTags) {
+      return kMaxTags;
+    }
+    tags_[index] = tag;
+    total_cycles_[index] = 0;
+    ++tag_count_;
+  }
+  start_cycles_[index] = esp_cpu_get_cycle_count();
+  return index;
+}
+
+void OpProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle < kMaxTags) {
+    total_cycles_[event_handle] +=
+        esp_cpu_get_cycle_count() - start_cycles_[event_handle];
+  }
+}
+
+void OpProfiler::Clear() { tag_count_ = 0; }
+
+void OpProfiler::Log(int invocations) const {
+  uint64_t total = 0;
+  for (int i = 0; i < tag_count_; ++i) {
+    MicroPrintf("    %-36s %u", tags_[i],
+                static_cast<unsigned>(total_cycles_[i] / invocations));
+    total += total_cycles_[i];
+  }
+  MicroPrintf("    %-36s %u", "total",
+              static_cast<unsigned>(total / invocations));
+}
+
+void RunAudioBufferBenchmark() {
+  MicroPrintf("Audio buffer read latency, %d byte window, cycles per read:",
+              kWindowBytes);
+
+  ringbuf_t* sram = rb_init_caps("bench_sram", kFlatBufferSize,
+                                 MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (sram) {
+    Prefill(sram, kFlatBufferSize);
+    MicroPrintf("  SRAM only:          %u",
+                TimeWindowReads(sram, &sram, 1, 0));
+    rb_cleanup(sram);
+  } else {
+    MicroPrintf("  SRAM only:          not enough internal memory");
+  }
+
+  ringbuf_t* psram = rb_init_caps("bench_psram", kFlatBufferSize,
+                                  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (psram) {
+    Prefill(psram, kFlatBufferSize);
+    MicroPrintf("  PSRAM only:         %u",
+                TimeWindowReads(psram, &psram, 1, 0));
+    rb_cleanup(psram);
+  } else {
+    MicroPrintf("  PSRAM only:         no PSRAM available");
+  }
+
+  ringbuf_t* tiers[2] = {
+      rb_init_caps("bench_hot", kHotBufferSize,
+                   MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+      rb_init_caps("bench_history", kHistoryBufferSize,
+                   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)};
+  if (tiers[0] && tiers[1]) {
+    Prefill(tiers[0], kHotBufferSize);
+    Prefill(tiers[1], kHistoryBufferSize);
+    MicroPrintf("  Tiered, hot read:   %u",
+                TimeWindowReads(tiers[0], tiers, 2, 0));
+    MicroPrintf("  Tiered, look-back:  %u (%d ms back)",
+                TimeWindowReads(tiers[1], tiers, 2, kLookBackBytes),
+                kLookBackBytes / 2 / (kAudioSampleFrequency / 1000));
+  } else {
+    MicroPrintf("  Tiered:             allocation failed");
+  }
+  for (ringbuf_t* rb : tiers) {
+    if (rb) {
+      rb_cleanup(rb);
+    }
+  }
+}
+
+void RunFrontendBenchmark() {
+  MicroPrintf("Audio frontend, %d slices per clip, cycles per slice:",
+              kFeatureCount);
+  static AudioFrontend frontend;
+  for (const TestClip& clip : kTestClips) {
+    const int16_t* samples =
+        reinterpret_cast<const int16_t*>(clip.wav + kWavHeaderBytes);
+
+    uint32_t start = esp_cpu_get_cycle_count();
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL
+    if (GenerateReferenceFeatures(samples, kClipSampleCount,
+                                  &g_reference_features) != kTfLiteOk) {
+      MicroPrintf("  %s: preprocessor model failed", clip.name);
+      continue;
+    }
+#endif
+    const uint32_t reference_cycles = esp_cpu_get_cycle_count() - start;
+
+    frontend.Reset();
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < kFeatureCount; ++i) {
+      frontend.ProcessWindow(samples + i * kAudioSampleStrideCount,
+                             g_native_features[i]);
+    }
+    const uint32_t native_cycles = esp_cpu_get_cycle_count() - start;
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL
+    int mismatches = CountMismatches(g_native_features, g_reference_features);
+#else
+    // Features the model can't compute are only checked for streaming the
+    // same as whole windows.
+    memcpy(g_reference_features, g_native_features, sizeof(Features));
+    int mismatches = 0;
+#endif
+
+    // The same slices again, streamed in one stride at a time after the
+    // first window.
+    frontend.Reset();
+    start = esp_cpu_get_cycle_count();
+    frontend.ProcessWindow(samples, g_native_features[0]);
+    for (int i = 1; i < kFeatureCount; ++i) {
+      frontend.PushStride(
+          samples + i * kAudioSampleStrideCount + AudioFrontend::kOverlapCount,
+          g_native_features[i]);
+    }
+    const uint32_t stream_cycles = esp_cpu_get_cycle_count() - start;
+    mismatches += CountMismatches(g_native_features, g_reference_features);
+
+    MicroPrintf("  %-8s model: %u  native: %u  streamed: %u  mismatches: %d",
+                clip.name,
+                static_cast<unsigned>(reference_cycles / kFeatureCount),
+                static_cast<unsigned>(native_cycles / kFeatureCount),
+                static_cast<unsigned>(stream_cycles / kFeatureCount),
+                mismatches);
+  }
+}
+
+void RunBatchBenchmark() {
+  MicroPrintf("Filling all %d slices on \"%s\", cycles in total:",
+              kFeatureCount, kTestClips[0].name);
+  const int16_t* samples =
+      reinterpret_cast<const int16_t*>(kTestClips[0].wav + kWavHeaderBytes);
+
+  // One window at a time, the way PopulateFeatureData used to.
+  InitializeMicroFeatures();
+  uint32_t start = esp_cpu_get_cycle_count();
+  for (int i = 0; i < kFeatureCount; ++i) {
+    if (GenerateFeatures(samples + i * kAudioSampleStrideCount,
+                         kAudioSampleDurationCount,
+                         &g_slice_features) != kTfLiteOk) {
+      MicroPrintf("  feature generation failed");
+      return;
+    }
+    for (int j = 0; j < kFeatureSize; ++j) {
+      g_reference_features[i][j] = g_slice_features[0][j];
+    }
+  }
+  const uint32_t single_cycles = esp_cpu_get_cycle_count() - start;
+
+  // All of them in one batch, split over both cores when
+  // MICRO_FEATURES_PARALLEL_SLICES is set. The cycle counter is core 0's, so
+  // this is the time until the features are ready.
+  InitializeMicroFeatures();
+  start = esp_cpu_get_cycle_count();
+  if (GenerateFeatureSlices(samples, kFeatureCount, g_native_features[0]) !=
+      kTfLiteOk) {
+    MicroPrintf("  feature generation failed");
+    return;
+  }
+  const uint32_t batch_cycles = esp_cpu_get_cycle_count() - start;
+  MicroPrintf("  per slice: %u  batched: %u  mismatches: %d",
+              static_cast<unsigned>(single_cycles),
+              static_cast<unsigned>(batch_cycles),
+              CountMismatches(g_native_features, g_reference_features));
+  InitializeMicroFeatures();
+}
+
+void RunSpectrogramBenchmark() {
+  MicroPrintf("Spectrogram update for one new slice, cycles per inference:");
+  for (int i = 0; i < kFeatureElementCount; ++i) {
+    g_spectrogram[i] = static_cast<int8_t>(i);
+  }
+
+  // Shifting every kept row up by one, then copying the features into the
+  // input an element at a time, as PopulateFeatureData and loop() used to.
+  uint32_t start = esp_cpu_get_cycle_count();
+  for (int n = 0; n < kBenchmarkIterations; ++n) {
+    for (int dest = 0; dest < kFeatureCount - 1; ++dest) {
+      for (int j = 0; j < kFeatureSize; ++j) {
+        g_spectrogram[dest * kFeatureSize + j] =
+            g_spectrogram[(dest + 1) * kFeatureSize + j];
+      }
+    }
+    for (int i = 0; i < kFeatureElementCount; ++i) {
+      g_model_input[i] = g_spectrogram[i];
+    }
+  }
+  const uint32_t shift_cycles = esp_cpu_get_cycle_count() - start;
+
+  // Advancing the ring's head, then copying the two segments either side of
+  // it, as FeatureProvider::CopyWindow does.
+  int head = 0;
+  start = esp_cpu_get_cycle_count();
+  for (int n = 0; n < kBenchmarkIterations; ++n) {
+    head = (head + 1 < kFeatureCount) ? head + 1 : 0;
+    const int head_size = (kFeatureCount - head) * kFeatureSize;
+    memcpy(g_model_input, g_spectrogram + head * kFeatureSize, head_size);
+    memcpy(g_model_input + head_size, g_spectrogram, head * kFeatureSize);
+  }
+  const uint32_t ring_cycles = esp_cpu_get_cycle_count() - start;
+
+  MicroPrintf("  shifted rows: %u  ring: %u",
+              static_cast<unsigned>(shift_cycles / kBenchmarkIterations),
+              static_cast<unsigned>(ring_cycles / kBenchmarkIterations));
+}
+
+void RunSignalKernelBenchmark() {
+  // The profilers are only attached when the benchmarks are built in.
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL && MICRO_SPEECH_RUN_BENCHMARKS
+  const int16_t* samples =
+      reinterpret_cast<const int16_t*>(kTestClips[0].wav + kWavHeaderBytes);
+  MicroPrintf("Preprocessor model ops on \"%s\", cycles per slice:",
+              kTestClips[0].name);
+  const struct {
+    const char* name;
+    SignalKernels kernels;
+    Features* features;
+  } kRuns[] = {
+      {"stock", SignalKernels::kStock, &g_reference_features},
+      {"fast", SignalKernels::kFast, &g_native_features},
+  };
+  for (const auto& run : kRuns) {
+    OpProfiler& profiler = ReferenceModelProfiler(run.kernels);
+    profiler.Clear();
+    if (GenerateReferenceFeatures(samples, kClipSampleCount, run.features,
+                                  run.kernels) != kTfLiteOk) {
+      MicroPrintf("  %s signal kernels: preprocessor model failed", run.name);
+      return;
+    }
+    MicroPrintf("  %s signal kernels:", run.name);
+    profiler.Log(kFeatureCount);
+  }
+  MicroPrintf("  mismatches: %d",
+              CountMismatches(g_native_features, g_reference_features));
+#endif
+}
+
+void RunBenchmarks() {
+  MicroPrintf("--- Running benchmarks ---");
+  RunAudioBufferBenchmark();
+  RunFrontendBenchmark();
+  RunBatchBenchmark();
+  RunSpectrogramBenchmark();
+  RunSignalKernelBenchmark();
+  MicroPrintf("--- Benchmarks finished ---");
+}
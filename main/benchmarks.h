@@ -0,0 +1,74 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_BENCHMARKS_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_BENCHMARKS_H_
+
+// Set to 1 to run the on-device benchmarks at the end of setup(). Results are
+// printed through MicroPrintf, in CPU cycles unless stated otherwise.
+#ifndef MICRO_SPEECH_RUN_BENCHMARKS
+#define MICRO_SPEECH_RUN_BENCHMARKS 0
+#endif
+
+#include <cstdint>
+
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+// Accumulates the cycles spent in each op of an interpreter, by op name, so
+// the time of a whole model can be broken down.
+class OpProfiler : public tflite::MicroProfilerInterface {
+ public:
+  uint32_t BeginEvent(const char* tag) override;
+  void EndEvent(uint32_t event_handle) override;
+
+  void Clear();
+  // Prints the cycles spent in each op, divided by `invocations`.
+  void Log(int invocations) const;
+
+ private:
+  static constexpr int kMaxTags = 24;
+  const char* tags_[kMaxTags];
+  uint64_t total_cycles_[kMaxTags];
+  uint32_t start_cycles_[kMaxTags];
+  int tag_count_ = 0;
+};
+
+// Runs every benchmark below in turn.
+void RunBenchmarks();
+
+// Compares the latency of reading one feature window of audio from a ring
+// buffer in internal SRAM, in PSRAM, and from the tiered SRAM + PSRAM layout
+// used by the audio provider.
+void RunAudioBufferBenchmark();
+
+// Runs the test clips through both the preprocessor model and the native
+// frontend, whole windows at a time and streamed stride by stride, timing
+// each, and counts the features on which they disagree.
+void RunFrontendBenchmark();
+
+// Times filling a whole spectrogram, as on the first run, slice by slice and
+// with a single batched call.
+void RunBatchBenchmark();
+
+// Times handing the spectrogram to the model after each new slice, shifting
+// the rows against advancing the head of a ring of rows.
+void RunSpectrogramBenchmark();
+
+// Breaks the preprocessor model down op by op, running it with the stock
+// signal kernels and then with the ones from signal_kernels.h, and checks
+// that both give the same features.
+void RunSignalKernelBenchmark();
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_BENCHMARKS_H_
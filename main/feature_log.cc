@@ -0,0 +1,193 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "feature_log.h"
+
+#if MICRO_SPEECH_FEATURE_LOG
+
+#include <cstring>
+
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "feature_log_format.h"
+#include "micro_model_settings.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace {
+
+constexpr char kPartitionLabel[] = "featlog";
+constexpr uint32_t kWriterStackSize = 3 * 1024;
+// Below the tensorflow task, so writing only uses time it leaves idle.
+constexpr UBaseType_t kWriterPriority = 2;
+constexpr int kBlockCount = 2;
+
+static_assert(kFeatureSize <= FeatureLogEncoder::kMaxFeatureSize,
+              "Rows are too wide for the feature log");
+
+// A full block and where in the partition it goes.
+struct BlockWrite {
+  int index;
+  uint32_t offset;
+};
+
+const esp_partition_t* g_partition = nullptr;
+uint8_t g_blocks[kBlockCount][kFeatureLogBlockSize];
+// Blocks that are free to fill, and blocks waiting for the writer.
+QueueHandle_t g_free_blocks = nullptr;
+QueueHandle_t g_full_blocks = nullptr;
+FeatureLogEncoder g_encoder(kFeatureSize, kCategoryCount, kFeatureStrideMs);
+// The block being filled, or -1.
+int g_active_block = -1;
+uint32_t g_next_offset = 0;
+uint32_t g_next_sequence = 0;
+FeatureLogCounters g_counters;
+// Only the writer task changes this.
+volatile uint32_t g_blocks_written = 0;
+
+// Erasing and writing a sector takes tens of milliseconds, which is why it
+// happens here rather than in the tensorflow task. The flash is still
+// unavailable to both cores meanwhile, unless the flash chip supports
+// CONFIG_SPI_FLASH_AUTO_SUSPEND.
+void FeatureLogWriter(void* arg) {
+  while (true) {
+    BlockWrite write;
+    xQueueReceive(g_full_blocks, &write, portMAX_DELAY);
+    if (esp_partition_erase_range(g_partition, write.offset,
+                                  kFeatureLogBlockSize) != ESP_OK ||
+        esp_partition_write(g_partition, write.offset, g_blocks[write.index],
+                            kFeatureLogBlockSize) != ESP_OK) {
+      MicroPrintf("Feature log write at 0x%x failed",
+                  static_cast<unsigned>(write.offset));
+    } else {
+      g_blocks_written = g_blocks_written + 1;
+    }
+    xQueueSend(g_free_blocks, &write.index, portMAX_DELAY);
+  }
+}
+
+// Makes sure there's a block to add records to, without waiting for one.
+bool HaveActiveBlock() {
+  if (g_active_block >= 0) {
+    return true;
+  }
+  if (g_next_offset + kFeatureLogBlockSize > g_partition->size ||
+      xQueueReceive(g_free_blocks, &g_active_block, 0) != pdTRUE) {
+    g_active_block = -1;
+    return false;
+  }
+  g_encoder.StartBlock(g_blocks[g_active_block], g_next_sequence++);
+  return true;
+}
+
+void SubmitActiveBlock() {
+  g_encoder.FinishBlock();
+  const BlockWrite write = {g_active_block, g_next_offset};
+  g_next_offset += kFeatureLogBlockSize;
+  // There are only kBlockCount blocks, so this queue always has room.
+  xQueueSend(g_full_blocks, &write, 0);
+  g_active_block = -1;
+}
+
+// Adds a record with add, moving on to the next block if it's full.
+template <typename AddRecord>
+bool Append(AddRecord add) {
+  if (g_partition == nullptr) {
+    return false;
+  }
+  if (HaveActiveBlock() && add()) {
+    return true;
+  }
+  if (g_active_block >= 0) {
+    SubmitActiveBlock();
+  }
+  if (HaveActiveBlock() && add()) {
+    return true;
+  }
+  ++g_counters.dropped;
+  return false;
+}
+
+}  // namespace
+
+TfLiteStatus FeatureLogStart() {
+  if (g_partition != nullptr) {
+    return kTfLiteOk;
+  }
+  const esp_partition_t* partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, kPartitionLabel);
+  if (partition == nullptr) {
+    MicroPrintf("No \"%s\" partition for the feature log", kPartitionLabel);
+    return kTfLiteError;
+  }
+
+  // Carry on after the blocks of the log that's already there.
+  uint32_t offset = 0;
+  uint32_t sequence = 0;
+  while (offset + kFeatureLogBlockSize <= partition->size) {
+    FeatureLogBlockHeader header;
+    if (esp_partition_read(partition, offset, &header, sizeof(header)) !=
+            ESP_OK ||
+        header.magic != kFeatureLogMagic ||
+        header.version != kFeatureLogVersion) {
+      break;
+    }
+    sequence = header.sequence + 1;
+    offset += kFeatureLogBlockSize;
+  }
+
+  g_free_blocks = xQueueCreate(kBlockCount, sizeof(int));
+  g_full_blocks = xQueueCreate(kBlockCount, sizeof(BlockWrite));
+  if (g_free_blocks == nullptr || g_full_blocks == nullptr) {
+    MicroPrintf("Could not create the feature log's queues");
+    return kTfLiteError;
+  }
+  for (int i = 0; i < kBlockCount; ++i) {
+    xQueueSend(g_free_blocks, &i, 0);
+  }
+  if (xTaskCreate(FeatureLogWriter, "feature_log", kWriterStackSize, nullptr,
+                  kWriterPriority, nullptr) != pdPASS) {
+    MicroPrintf("Could not start the feature log writer");
+    return kTfLiteError;
+  }
+  g_next_offset = offset;
+  g_next_sequence = sequence;
+  memset(&g_counters, 0, sizeof(g_counters));
+  g_partition = partition;
+  MicroPrintf("Feature log at %u of %u bytes", static_cast<unsigned>(offset),
+              static_cast<unsigned>(partition->size));
+  return kTfLiteOk;
+}
+
+void FeatureLogRow(int32_t time_ms, const int8_t* row, bool gap) {
+  if (Append([&] { return g_encoder.AddRow(time_ms, row, gap); })) {
+    ++g_counters.rows;
+  }
+}
+
+void FeatureLogScores(int32_t time_ms, const int8_t* scores) {
+  if (Append([&] { return g_encoder.AddScores(time_ms, scores); })) {
+    ++g_counters.scores;
+  }
+}
+
+FeatureLogCounters FeatureLogGetCounters() {
+  FeatureLogCounters counters = g_counters;
+  counters.blocks_written = g_blocks_written;
+  return counters;
+}
+
+#endif  // MICRO_SPEECH_FEATURE_LOG
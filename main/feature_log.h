@@ -0,0 +1,53 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_LOG_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_LOG_H_
+
+// Set to 1 to record every spectrogram row and every set of model scores to
+// the "featlog" flash partition, in the format of feature_log_format.h, for
+// collecting data on site. Read the partition back with esptool's
+// read_flash and convert it with tools/feature_log_reader.py.
+#ifndef MICRO_SPEECH_FEATURE_LOG
+#define MICRO_SPEECH_FEATURE_LOG 0
+#endif
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+struct FeatureLogCounters {
+  uint32_t rows;
+  uint32_t scores;
+  uint32_t blocks_written;
+  // Records lost because both blocks were waiting to be written, or the
+  // partition was full.
+  uint32_t dropped;
+};
+
+// Finds the partition and starts the task that writes to it. Logging goes on
+// after whatever the partition already holds, up to the first block that
+// isn't part of a log.
+TfLiteStatus FeatureLogStart();
+
+// Append a record. They never wait for flash: records are collected in one
+// block in RAM while the other one is written out, and are dropped if both
+// are full. Calls before a successful FeatureLogStart are ignored.
+void FeatureLogRow(int32_t time_ms, const int8_t* row, bool gap);
+void FeatureLogScores(int32_t time_ms, const int8_t* scores);
+
+FeatureLogCounters FeatureLogGetCounters();
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_LOG_H_
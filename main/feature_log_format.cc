@@ -0,0 +1,150 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "feature_log_format.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+// Longest literal and repeat runs a control byte can describe.
+constexpr int kMaxRun = 128;
+
+// Most bytes a record can have before its row or scores: the type and two
+// varints of up to five bytes.
+constexpr int kMaxRecordHeader = 11;
+
+int PutVarint(uint8_t* output, uint32_t value) {
+  int written = 0;
+  while (value >= 0x80) {
+    output[written++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  output[written++] = static_cast<uint8_t>(value);
+  return written;
+}
+
+// Small negative and positive differences both get short varints.
+uint32_t ZigZag(int32_t value) {
+  return (static_cast<uint32_t>(value) << 1) ^
+         static_cast<uint32_t>(value >> 31);
+}
+
+}  // namespace
+
+int FeatureLogPackBits(const uint8_t* input, int size, uint8_t* output) {
+  int written = 0;
+  int i = 0;
+  while (i < size) {
+    int repeat = 1;
+    while (i + repeat < size && repeat < kMaxRun &&
+           input[i + repeat] == input[i]) {
+      ++repeat;
+    }
+    // A pair only pays off as a repeat when it doesn't split a literal run.
+    if (repeat >= 3 || (repeat == 2 && (i == 0 || i + 2 == size))) {
+      output[written++] = static_cast<uint8_t>(257 - repeat);
+      output[written++] = input[i];
+      i += repeat;
+      continue;
+    }
+    // Literals up to the next run of three or the longest a control byte
+    // allows.
+    int literal = 1;
+    while (i + literal < size && literal < kMaxRun &&
+           !(i + literal + 2 < size &&
+             input[i + literal] == input[i + literal + 1] &&
+             input[i + literal] == input[i + literal + 2])) {
+      ++literal;
+    }
+    output[written++] = static_cast<uint8_t>(literal - 1);
+    memcpy(output + written, input + i, literal);
+    written += literal;
+    i += literal;
+  }
+  return written;
+}
+
+FeatureLogEncoder::FeatureLogEncoder(int feature_size, int score_count,
+                                     int stride_ms)
+    : feature_size_(feature_size),
+      score_count_(score_count),
+      stride_ms_(stride_ms),
+      block_(nullptr),
+      used_(0),
+      previous_time_ms_(0) {
+  memset(previous_row_, 0, sizeof(previous_row_));
+}
+
+void FeatureLogEncoder::StartBlock(uint8_t* block, uint32_t sequence) {
+  block_ = block;
+  FeatureLogBlockHeader header;
+  header.magic = kFeatureLogMagic;
+  header.version = kFeatureLogVersion;
+  header.used = sizeof(FeatureLogBlockHeader);
+  header.sequence = sequence;
+  header.feature_size = static_cast<uint8_t>(feature_size_);
+  header.score_count = static_cast<uint8_t>(score_count_);
+  header.stride_ms = static_cast<uint8_t>(stride_ms_);
+  header.reserved = 0;
+  memcpy(block_, &header, sizeof(header));
+  used_ = sizeof(FeatureLogBlockHeader);
+  previous_time_ms_ = 0;
+  memset(previous_row_, 0, sizeof(previous_row_));
+}
+
+bool FeatureLogEncoder::AddRow(int32_t time_ms, const int8_t* row, bool gap) {
+  uint8_t delta[kMaxFeatureSize];
+  for (int i = 0; i < feature_size_; ++i) {
+    delta[i] = static_cast<uint8_t>(row[i] - previous_row_[i]);
+  }
+  uint8_t packed[kMaxFeatureSize + (kMaxFeatureSize + kMaxRun - 1) / kMaxRun];
+  const int length = FeatureLogPackBits(delta, feature_size_, packed);
+  if (used_ + kMaxRecordHeader + length > kFeatureLogBlockSize) {
+    return false;
+  }
+  uint8_t* record = block_ + used_;
+  int written = 0;
+  record[written++] = kFeatureLogRow | (gap ? kFeatureLogRowGap : 0);
+  written += PutVarint(record + written, ZigZag(time_ms - previous_time_ms_));
+  written += PutVarint(record + written, length);
+  memcpy(record + written, packed, length);
+  used_ += written + length;
+  previous_time_ms_ = time_ms;
+  memcpy(previous_row_, row, feature_size_);
+  return true;
+}
+
+bool FeatureLogEncoder::AddScores(int32_t time_ms, const int8_t* scores) {
+  if (used_ + kMaxRecordHeader + score_count_ > kFeatureLogBlockSize) {
+    return false;
+  }
+  uint8_t* record = block_ + used_;
+  int written = 0;
+  record[written++] = kFeatureLogScores;
+  written += PutVarint(record + written, ZigZag(time_ms - previous_time_ms_));
+  written += PutVarint(record + written, score_count_);
+  memcpy(record + written, scores, score_count_);
+  used_ += written + score_count_;
+  previous_time_ms_ = time_ms;
+  return true;
+}
+
+int FeatureLogEncoder::FinishBlock() {
+  const uint16_t used = static_cast<uint16_t>(used_);
+  memcpy(block_ + offsetof(FeatureLogBlockHeader, used), &used, sizeof(used));
+  return used_;
+}
@@ -0,0 +1,106 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_LOG_FORMAT_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_LOG_FORMAT_H_
+
+#include <cstdint>
+
+// The feature log is a sequence of fixed size blocks, one flash sector each,
+// so that blocks can be erased and written one at a time and a log cut short
+// by a power loss still reads back up to its last whole block. Every block
+// starts with a FeatureLogBlockHeader and is followed by records, each of
+// which starts with its type:
+//
+//   kFeatureLogRow:    type | flags, time, length, length bytes of row
+//   kFeatureLogScores: type, time, count, count int8 scores
+//
+// The time is the record's time in milliseconds less the previous record's,
+// zigzag coded as a varint: 7 bits a byte, low bits first, the top bit set
+// on all but the last byte. Lengths are varints too, and the header's
+// fields are little endian. A row is the difference from the previous row
+// of the block, byte by byte and wrapping, packed with FeatureLogPackBits.
+// The first record of a block is taken against a time of zero and a row of
+// zeros, so every block decodes on its own. Anything after the header's used
+// bytes, and any block without the magic, such as erased flash, is not part
+// of the log. tools/feature_log_reader.py reads it back.
+
+constexpr int kFeatureLogBlockSize = 4096;
+constexpr uint32_t kFeatureLogMagic = 0x4c53574b;  // "KWSL"
+constexpr uint16_t kFeatureLogVersion = 1;
+
+constexpr uint8_t kFeatureLogRow = 1;
+constexpr uint8_t kFeatureLogScores = 2;
+
+// Row flags, in the top bits of the type byte.
+constexpr uint8_t kFeatureLogRowGap = 0x80;
+
+struct FeatureLogBlockHeader {
+  uint32_t magic;
+  uint16_t version;
+  // Bytes of the block in use, header included.
+  uint16_t used;
+  // Counts up from zero over the blocks of a log.
+  uint32_t sequence;
+  uint8_t feature_size;
+  uint8_t score_count;
+  uint8_t stride_ms;
+  uint8_t reserved;
+};
+static_assert(sizeof(FeatureLogBlockHeader) == 16,
+              "The block header is part of the file format");
+
+// PackBits run-length coding: a control byte c of 0 to 127 is followed by
+// c + 1 literal bytes, and one of 129 to 255 by a single byte repeated
+// 257 - c times. Returns the bytes written to output, which needs room for
+// size + (size + 127) / 128.
+int FeatureLogPackBits(const uint8_t* input, int size, uint8_t* output);
+
+// Fills in blocks of the feature log, one at a time. The caller owns the
+// blocks and decides where they go once they are full.
+class FeatureLogEncoder {
+ public:
+  FeatureLogEncoder(int feature_size, int score_count, int stride_ms);
+
+  // Starts filling block, which must hold kFeatureLogBlockSize bytes.
+  void StartBlock(uint8_t* block, uint32_t sequence);
+
+  // Append a record to the block. They return false, leaving the block as
+  // it was, if the record doesn't fit, and then the block has to be
+  // finished and the record added to a new one.
+  bool AddRow(int32_t time_ms, const int8_t* row, bool gap);
+  bool AddScores(int32_t time_ms, const int8_t* scores);
+
+  // Writes the used size into the header, and returns it.
+  int FinishBlock();
+
+  bool BlockIsEmpty() const { return used_ == sizeof(FeatureLogBlockHeader); }
+
+  // Room for the largest row record.
+  static constexpr int kMaxFeatureSize = 255;
+
+ private:
+  int feature_size_;
+  int score_count_;
+  int stride_ms_;
+  uint8_t* block_;
+  int used_;
+  // The last time and row added to the block, which the next record is
+  // taken against.
+  int32_t previous_time_ms_;
+  int8_t previous_row_[kMaxFeatureSize];
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_LOG_FORMAT_H_
@@ -17,8 +17,10 @@ limitations under the License.
 #include <freertos/task.h>
 
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #include <cstring>
+#include <limits>
 #include "feature_provider.h"
 
 #include "audio_provider.h"
@@ -33,114 +35,361 @@ extern const uint8_t no_1000ms_start[]        asm("_binary_no_1000ms_wav_start")
 extern const uint8_t noise_1000ms_start[]     asm("_binary_noise_1000ms_wav_start");
 extern const uint8_t silence_1000ms_start[]   asm("_binary_silence_1000ms_wav_start");
 
-Features g_features;
 const char *TAG = "feature_provider";
 
-FeatureProvider::FeatureProvider(int feature_size, int8_t* feature_data)
-    : feature_size_(feature_size),
-      feature_data_(feature_data),
-      is_first_run_(true) {
+namespace {
+
+// Fewest new slices that are worth fetching and computing as one batch.
+constexpr int kMinBatchSlices = 2;
+
+#if MICRO_FEATURES_WARM_START
+// The audio from before recording started reads as zeros, so a window of
+// zeros gives the row every slice of a warm started window would have had.
+const int16_t kSilentWindow[kAudioSampleDurationCount] = {};
+#endif
+
+}  // namespace
+
+template <int FeatureSize, int FeatureCount, int StrideMs>
+BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::BasicFeatureProvider(
+    int8_t* feature_data)
+    : feature_data_(feature_data),
+      head_(0),
+      live_slices_(0),
+      is_first_run_(true),
+      has_streamed_step_(false),
+      streamed_step_(0) {
   // Initialize the feature data to default values.
-  for (int n = 0; n < feature_size_; ++n) {
-    feature_data_[n] = 0;
+  memset(feature_data_, 0, kElementCount);
+  for (int n = 0; n < FeatureCount; ++n) {
+    slice_has_gap_[n] = false;
   }
+  memset(slice_stats_, 0, sizeof(slice_stats_));
+  memset(&backlog_counters_, 0, sizeof(backlog_counters_));
+#if MICRO_FEATURES_CATCH_UP_FILL == MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR
+  memset(noise_floor_row_, 0, sizeof(noise_floor_row_));
+#endif
 }
 
-FeatureProvider::~FeatureProvider() {}
+template <int FeatureSize, int FeatureCount, int StrideMs>
+bool BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::WindowHasGap()
+    const {
+  if (live_slices_ < kWarmStartSlices) {
+    return true;
+  }
+  for (int n = 0; n < FeatureCount; ++n) {
+    if (slice_has_gap_[n]) {
+      return true;
+    }
+  }
+  return false;
+}
 
-TfLiteStatus FeatureProvider::PopulateFeatureData(
-    int32_t last_time_in_ms, int32_t time_in_ms, int* how_many_new_slices) {
-  if (feature_size_ != kFeatureElementCount) {
-    MicroPrintf("Requested feature_data_ size %d doesn't match %d",
-                feature_size_, kFeatureElementCount);
-    return kTfLiteError;
+template <int FeatureSize, int FeatureCount, int StrideMs>
+void BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::CopyWindow(
+    int8_t* output) const {
+  const int head_size = (FeatureCount - head_) * FeatureSize;
+  memcpy(output, feature_data_ + head_ * FeatureSize, head_size);
+  memcpy(output + head_size, feature_data_, head_ * FeatureSize);
+}
+
+template <int FeatureSize, int FeatureCount, int StrideMs>
+void BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::Restart() {
+  head_ = 0;
+  live_slices_ = 0;
+  is_first_run_ = true;
+  has_streamed_step_ = false;
+  for (int n = 0; n < FeatureCount; ++n) {
+    slice_has_gap_[n] = false;
   }
+  memset(slice_stats_, 0, sizeof(slice_stats_));
+  memset(&backlog_counters_, 0, sizeof(backlog_counters_));
+#if MICRO_FEATURES_CATCH_UP_FILL == MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR
+  memset(noise_floor_row_, 0, sizeof(noise_floor_row_));
+#endif
+}
 
+template <int FeatureSize, int FeatureCount, int StrideMs>
+void BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::SkipSlices(
+    int first_slice, int end_slice) {
+#if MICRO_FEATURES_CATCH_UP_FILL == MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR
+  // The rows are still those of the window before the stall, so the quietest
+  // of them that was computed from clean audio is what the room sounds like.
+  // Without one, the previous noise floor is kept.
+  int quietest_row = -1;
+  for (int row = 0; row < FeatureCount; ++row) {
+    if (!slice_has_gap_[row] &&
+        (quietest_row < 0 ||
+         slice_stats_[row].energy < slice_stats_[quietest_row].energy)) {
+      quietest_row = row;
+    }
+  }
+  if (quietest_row >= 0) {
+    memcpy(noise_floor_row_, feature_data_ + quietest_row * FeatureSize,
+           FeatureSize);
+  }
+#endif
+  for (int slice = first_slice; slice < end_slice; ++slice) {
+    const int row = RowOf(slice);
+#if MICRO_FEATURES_CATCH_UP_FILL == MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR
+    memcpy(feature_data_ + row * FeatureSize, noise_floor_row_, FeatureSize);
+#else
+    memset(feature_data_ + row * FeatureSize, 0, FeatureSize);
+#endif
+    memset(&slice_stats_[row], 0, sizeof(FrontendSliceStats));
+    slice_has_gap_[row] = true;
+  }
+  ESP_LOGW(TAG, "Skipped %d slices to catch up", end_slice - first_slice);
+  has_streamed_step_ = false;
+  ++backlog_counters_.catch_ups;
+  backlog_counters_.skipped_slices += end_slice - first_slice;
+}
+
+template <int FeatureSize, int FeatureCount, int StrideMs>
+TfLiteStatus
+BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::GenerateSliceBatch(
+    int current_step, int first_slice, bool* generated) {
+  *generated = false;
+  const int slice_count = FeatureCount - first_slice;
+  const int32_t start_ms = SliceStartMs(current_step, first_slice);
+  const int duration_ms =
+      (slice_count - 1) * StrideMs + kFeatureDurationMs;
+  const int sample_count = (slice_count - 1) * kStrideSamples +
+                           kAudioSampleDurationCount;
+  int16_t* audio_samples = nullptr;
+  int audio_samples_size = 0;
+  if (GetAudioSamples(start_ms, duration_ms, &audio_samples_size,
+                      &audio_samples) != kTfLiteOk ||
+      audio_samples_size < sample_count ||
+      AudioRangeHasGap(
+          static_cast<int64_t>(start_ms) * (kAudioSampleFrequency / 1000),
+          sample_count)) {
+    return kTfLiteOk;
+  }
+  // The rows can wrap around the end of the ring, and then the slices after
+  // the wrap are a second run carrying on from the first.
+  const int16_t* run_samples = audio_samples;
+  for (int slice = first_slice; slice < FeatureCount;) {
+    const int row = RowOf(slice);
+    int run_count = FeatureCount - row;
+    if (run_count > FeatureCount - slice) {
+      run_count = FeatureCount - slice;
+    }
+    TF_LITE_ENSURE_STATUS(GenerateFeatureSlices(
+        &frontend_state_, run_samples, run_count,
+        feature_data_ + row * FeatureSize, slice_stats_ + row));
+    for (int n = row; n < row + run_count; ++n) {
+      slice_has_gap_[n] = false;
+    }
+    run_samples += run_count * kStrideSamples;
+    slice += run_count;
+  }
+  has_streamed_step_ = true;
+  streamed_step_ = current_step;
+  *generated = true;
+  return kTfLiteOk;
+}
+
+template <int FeatureSize, int FeatureCount, int StrideMs>
+TfLiteStatus
+BasicFeatureProvider<FeatureSize, FeatureCount, StrideMs>::PopulateFeatureData(
+    int32_t last_time_in_ms, int32_t time_in_ms, int* how_many_new_slices) {
   // Quantize the time into steps as long as each window stride, so we can
   // figure out which audio data we need to fetch.
-  const int last_step = (last_time_in_ms / kFeatureStrideMs);
-  const int current_step = (time_in_ms / kFeatureStrideMs);
+  const int last_step = (last_time_in_ms / StrideMs);
+  const int current_step = (time_in_ms / StrideMs);
 
   int slices_needed = current_step - last_step;
+  // If the model fell too far behind the microphone, the audio provider skips
+  // ahead to resume_ms. The skipped audio starts where the last fetch ended,
+  // so the kept rows don't overlap it and stay as they are. New slices whose
+  // window starts before resume_ms do, and are flagged as gaps below.
+  // Without a skip nothing is before it, not even the slices of a warm
+  // started window that start before recording did.
+  int32_t resume_ms = std::numeric_limits<int32_t>::min();
+  int32_t skip_resume_ms = 0;
+  if (!is_first_run_ && BoundAudioLatency(&skip_resume_ms) > 0) {
+    resume_ms = skip_resume_ms;
+    has_streamed_step_ = false;
+  }
   // If this is the first call, make sure we don't use any cached information.
+  const bool first_window = is_first_run_;
   if (is_first_run_) {
-    TfLiteStatus init_status = InitializeMicroFeatures();
+    TfLiteStatus init_status = InitializeMicroFeatures(&frontend_state_);
     if (init_status != kTfLiteOk) {
       return init_status;
     }
     ESP_LOGI(TAG, "InitializeMicroFeatures successful");
     is_first_run_ = false;
-    slices_needed = kFeatureCount;
+    has_streamed_step_ = false;
+#if MICRO_FEATURES_WARM_START
+    // The silent row is computed once and copied to every row, instead of
+    // computing the whole window before the first inference. Only the
+    // slices since the last step are then computed from live audio, and no
+    // more of them than a catch-up would compute, as the rest keep the seed.
+    if (slices_needed > kCatchUpSlices) {
+      slices_needed = kCatchUpSlices;
+    }
+    head_ = 0;
+    TfLiteStatus seed_status =
+        GenerateFeatureSlices(&frontend_state_, kSilentWindow, 1,
+                              feature_data_, slice_stats_);
+    if (seed_status != kTfLiteOk) {
+      return seed_status;
+    }
+    for (int row = 1; row < FeatureCount; ++row) {
+      memcpy(feature_data_ + row * FeatureSize, feature_data_, FeatureSize);
+      slice_stats_[row] = slice_stats_[0];
+    }
+#else
+    slices_needed = FeatureCount;
+#endif
   }
 #if 1
-  if (slices_needed > kFeatureCount) {
-    slices_needed = kFeatureCount;
+  if (slices_needed > FeatureCount) {
+    slices_needed = FeatureCount;
   }
   *how_many_new_slices = slices_needed;
+  backlog_counters_.backlog = slices_needed;
+  if (slices_needed > backlog_counters_.max_backlog) {
+    backlog_counters_.max_backlog = slices_needed;
+  }
 
-  const int slices_to_keep = kFeatureCount - slices_needed;
-  const int slices_to_drop = kFeatureCount - slices_to_keep;
-  // If we can avoid recalculating some slices, just move the existing data
-  // up in the spectrogram, to perform something like this:
+  const int slices_to_keep = FeatureCount - slices_needed;
+  // After a stall, computing every missing slice before the model runs again
+  // only makes the stall longer. Past kCatchUpSlices, the older ones are
+  // skipped. The first window is never skipped: it is either computed whole
+  // or warm started.
+  int first_computed_slice = slices_to_keep;
+  if (!first_window && slices_needed > kCatchUpSlices) {
+    first_computed_slice = FeatureCount - kCatchUpSlices;
+  }
+  // If we can avoid recalculating some slices, leave the existing data where
+  // it is and move the head past the rows that drop out of the window, which
+  // then take the new slices, to perform something like this:
   // last time = 80ms          current time = 120ms
-  // +-----------+             +-----------+
-  // | data@20ms |         --> | data@60ms |
-  // +-----------+       --    +-----------+
-  // | data@40ms |     --  --> | data@80ms |
-  // +-----------+   --  --    +-----------+
-  // | data@60ms | --  --      |  <empty>  |
-  // +-----------+   --        +-----------+
-  // | data@80ms | --          |  <empty>  |
-  // +-----------+             +-----------+
-  if (slices_to_keep > 0) {
-    for (int dest_slice = 0; dest_slice < slices_to_keep; ++dest_slice) {
-      int8_t* dest_slice_data =
-          feature_data_ + (dest_slice * kFeatureSize);
-      const int src_slice = dest_slice + slices_to_drop;
-      const int8_t* src_slice_data =
-          feature_data_ + (src_slice * kFeatureSize);
-      for (int i = 0; i < kFeatureSize; ++i) {
-        dest_slice_data[i] = src_slice_data[i];
-      }
-    }
+  //     +-----------+             +-----------+
+  // h-> | data@20ms |             |  <empty>  |
+  //     +-----------+             +-----------+
+  //     | data@40ms |             |  <empty>  |
+  //     +-----------+             +-----------+
+  //     | data@60ms |         h-> | data@60ms |
+  //     +-----------+             +-----------+
+  //     | data@80ms |             | data@80ms |
+  //     +-----------+             +-----------+
+  head_ = RowOf(slices_needed);
+  if (first_computed_slice > slices_to_keep) {
+    SkipSlices(slices_to_keep, first_computed_slice);
   }
   // Any slices that need to be filled in with feature data have their
   // appropriate audio data pulled, and features calculated for that slice.
   if (slices_needed > 0) {
-    for (int new_slice = slices_to_keep; new_slice < kFeatureCount;
+    // Runs of new slices, after a stall or on the first run, are computed
+    // together from a single fetch of the audio they span. Slices from before
+    // a skip can't be part of that and are left to the loop below, as are all
+    // of them if the span can't be fetched in one piece.
+    int batch_slice = first_computed_slice;
+    while (batch_slice < FeatureCount &&
+           SliceStartMs(current_step, batch_slice) < resume_ms) {
+      ++batch_slice;
+    }
+    int unbatched_end = FeatureCount;
+    if (FeatureCount - batch_slice >= kMinBatchSlices) {
+      bool batched = false;
+      TfLiteStatus batch_status =
+          GenerateSliceBatch(current_step, batch_slice, &batched);
+      if (batch_status != kTfLiteOk) {
+        return batch_status;
+      }
+      if (batched) {
+        unbatched_end = batch_slice;
+      }
+    }
+    for (int new_slice = first_computed_slice; new_slice < unbatched_end;
          ++new_slice) {
-      const int new_step = (current_step - kFeatureCount + 1) + new_slice;
-      const int32_t slice_start_ms = (new_step * kFeatureStrideMs);
+      const int new_step = (current_step - FeatureCount + 1) + new_slice;
+      // Each slice covers the window that ends on its step boundary, so the
+      // newest one is always made of audio that has already been captured.
+      const int32_t slice_start_ms = SliceStartMs(current_step, new_slice);
+      const int new_row = RowOf(new_slice);
+      int8_t* new_slice_data = feature_data_ + (new_row * FeatureSize);
+      // When the previous slice's window came right before this one, the
+      // frontend still has the part they share, and only the audio of the
+      // latest stride has to be fetched.
+      const bool continues_stream =
+          has_streamed_step_ && (new_step == streamed_step_ + 1);
+      const int32_t fetch_start_ms =
+          continues_stream
+              ? slice_start_ms + (kFeatureDurationMs - StrideMs)
+              : slice_start_ms;
+      const int fetch_duration_ms =
+          continues_stream ? StrideMs : kFeatureDurationMs;
+      const int fetch_sample_count = continues_stream
+                                         ? kStrideSamples
+                                         : kAudioSampleDurationCount;
       int16_t* audio_samples = nullptr;
       int audio_samples_size = 0;
-      // TODO(petewarden): Fix bug that leads to non-zero slice_start_ms
-      GetAudioSamples((slice_start_ms > 0 ? slice_start_ms : 0),
-                      kFeatureDurationMs, &audio_samples_size,
-                      &audio_samples);
-      if (audio_samples_size < kMaxAudioSampleSize) {
+      // Audio that was skipped, is gone, or was spliced together around lost
+      // samples gives a blank slice flagged as a gap, rather than failing the
+      // window or producing features that mix two different moments.
+      slice_has_gap_[new_row] =
+          (slice_start_ms < resume_ms) ||
+          (GetAudioSamples(fetch_start_ms, fetch_duration_ms,
+                           &audio_samples_size, &audio_samples) != kTfLiteOk) ||
+          AudioRangeHasGap(static_cast<int64_t>(slice_start_ms) *
+                               (kAudioSampleFrequency / 1000),
+                           kAudioSampleDurationCount);
+      if (slice_has_gap_[new_row]) {
+        for (int j = 0; j < FeatureSize; ++j) {
+          new_slice_data[j] = 0;
+        }
+        memset(&slice_stats_[new_row], 0, sizeof(FrontendSliceStats));
+        has_streamed_step_ = false;
+        continue;
+      }
+      if (audio_samples_size < fetch_sample_count) {
         MicroPrintf("Audio data size %d too small, want %d",
-                    audio_samples_size, kMaxAudioSampleSize);
+                    audio_samples_size, fetch_sample_count);
         return kTfLiteError;
       }
-      int8_t* new_slice_data = feature_data_ + (new_slice * kFeatureSize);
-      // size_t num_samples_read;
-      // TfLiteStatus generate_status = GenerateMicroFeatures(
-      //     audio_samples, audio_samples_size, kFeatureSize,
-      //     new_slice_data, &num_samples_read);
-      TfLiteStatus generate_status = GenerateFeatures(
-            audio_samples, audio_samples_size, &g_features);
-      if (generate_status != kTfLiteOk) {
-        return generate_status;
-      }
-
-      // copy features
-      for (int j = 0; j < kFeatureSize; ++j) {
-        new_slice_data[j] = g_features[0][j];
+      if (continues_stream) {
+        TfLiteStatus generate_status =
+            GenerateStrideFeatures(&frontend_state_, audio_samples,
+                                   new_slice_data, &slice_stats_[new_row]);
+        if (generate_status != kTfLiteOk) {
+          return generate_status;
+        }
+      } else {
+        // size_t num_samples_read;
+        // TfLiteStatus generate_status = GenerateMicroFeatures(
+        //     audio_samples, audio_samples_size, kFeatureSize,
+        //     new_slice_data, &num_samples_read);
+        // The window is read where the audio provider keeps it, and the
+        // features are written straight into their row of the spectrogram.
+        TfLiteStatus generate_status =
+            GenerateFeatureSlices(&frontend_state_, audio_samples, 1,
+                                  new_slice_data, &slice_stats_[new_row]);
+        if (generate_status != kTfLiteOk) {
+          return generate_status;
+        }
       }
+      has_streamed_step_ = true;
+      streamed_step_ = new_step;
+    }
+  }
+  if (live_slices_ < FeatureCount) {
+    const bool was_ready = live_slices_ >= kWarmStartSlices;
+    live_slices_ += FeatureCount - first_computed_slice;
+    if (live_slices_ > FeatureCount) {
+      live_slices_ = FeatureCount;
+    }
+    if (!was_ready && live_slices_ >= kWarmStartSlices) {
+      ESP_LOGI(TAG, "Window ready %lld ms after boot",
+               static_cast<long long>(esp_timer_get_time() / 1000));
     }
   }
 #elif 1
-    *how_many_new_slices = kFeatureCount;
+    *how_many_new_slices = FeatureCount;
     int16_t* audio_samples = nullptr;
     int audio_samples_size = 0;
     // GetAudioSamples(0, kFeatureDurationMs, &audio_samples_size, &audio_samples);
@@ -167,38 +416,39 @@ TfLiteStatus FeatureProvider::PopulateFeatureData(
 
     GetAudioSamples1(&audio_samples_size, &audio_samples);
 
+    head_ = 0;
+    live_slices_ = FeatureCount;
     TfLiteStatus generate_status = GenerateFeatures(
-          audio_samples, audio_samples_size, &g_features);
+          audio_samples, audio_samples_size,
+          reinterpret_cast<Features*>(feature_data_));
     if (generate_status != kTfLiteOk) {
       return generate_status;
     }
-    // copy features
-    for (int i = 0; i < kFeatureCount; ++i) {
-      for (int j = 0; j < kFeatureSize; ++j) {
-        feature_data_[i * kFeatureSize + j] = g_features[i][j];
-      }
-    }
     vTaskDelay(pdMS_TO_TICKS(500));
 #else
-    *how_many_new_slices = kFeatureCount;
+    *how_many_new_slices = FeatureCount;
     int16_t* audio_samples = nullptr;
     int audio_samples_size = 16000;
     GetAudioSamples(0, kFeatureDurationMs, &audio_samples_size, &audio_samples);
 
-    memset(g_features, 0, sizeof(g_features));
+    memset(feature_data_, 0, kElementCount);
 
+    head_ = 0;
+    live_slices_ = FeatureCount;
     TfLiteStatus generate_status = GenerateFeatures(
-          audio_samples, audio_samples_size, &g_features);
+          audio_samples, audio_samples_size,
+          reinterpret_cast<Features*>(feature_data_));
     if (generate_status != kTfLiteOk) {
       return generate_status;
     }
-    // copy features
-    for (int i = 0; i < kFeatureCount; ++i) {
-      for (int j = 0; j < kFeatureSize; ++j) {
-        feature_data_[i * kFeatureSize + j] = g_features[i][j];
-      }
-    }
     vTaskDelay(pdMS_TO_TICKS(500));
 #endif
   return kTfLiteOk;
 }
+
+// The provider the model's input comes from, and the half second window.
+// Windows of other lengths need a line like this of their own.
+template class BasicFeatureProvider<kFeatureSize, kFeatureCount,
+                                    kFeatureStrideMs>;
+template class BasicFeatureProvider<kFeatureSize, kShortFeatureCount,
+                                    kFeatureStrideMs>;
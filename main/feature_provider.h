@@ -16,8 +16,53 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_PROVIDER_H_
 #define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_PROVIDER_H_
 
+#include "frontend_stages.h"
+#include "micro_features_generator.h"
+#include "micro_model_settings.h"
 #include "tensorflow/lite/c/common.h"
 
+// How many of the newest missing slices PopulateFeatureData computes when it
+// has fallen behind. Older missing slices are filled in instead of computed,
+// and flagged like slices with gaps, so recognition waits until they have
+// left the window. Set this to kFeatureCount to always compute every slice.
+#ifndef MICRO_FEATURES_CATCH_UP_SLICES
+#define MICRO_FEATURES_CATCH_UP_SLICES 16
+#endif
+
+// What the slices skipped while catching up are filled with: zeros, like
+// slices with gaps, or the quietest slice of the window before the stall.
+#define MICRO_FEATURES_CATCH_UP_FILL_ZERO 0
+#define MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR 1
+#ifndef MICRO_FEATURES_CATCH_UP_FILL
+#define MICRO_FEATURES_CATCH_UP_FILL MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR
+#endif
+
+// With warm start, the first window is seeded with silence rather than
+// computed from the second of audio before it, so the model can run as soon
+// as the first live slices are in. Results are held back until the window
+// has MICRO_FEATURES_WARM_START_SLICES live slices in it.
+#ifndef MICRO_FEATURES_WARM_START
+#define MICRO_FEATURES_WARM_START 1
+#endif
+#ifndef MICRO_FEATURES_WARM_START_SLICES
+#define MICRO_FEATURES_WARM_START_SLICES (kFeatureCount / 2)
+#endif
+
+static_assert(MICRO_FEATURES_WARM_START_SLICES >= 1,
+              "MICRO_FEATURES_WARM_START_SLICES must be at least 1");
+static_assert(MICRO_FEATURES_CATCH_UP_SLICES >= 1,
+              "MICRO_FEATURES_CATCH_UP_SLICES must be at least 1");
+
+// How far PopulateFeatureData has fallen behind the audio.
+struct FeatureBacklogCounters {
+  // Slices that were missing on the latest call, and the most ever missing.
+  int backlog;
+  int max_backlog;
+  // Calls that skipped slices, and how many slices were skipped in total.
+  uint32_t catch_ups;
+  uint32_t skipped_slices;
+};
+
 // Binds itself to an area of memory intended to hold the input features for an
 // audio-recognition neural network model, and fills that data area with the
 // features representing the current audio input, for example from a microphone.
@@ -25,26 +70,154 @@ limitations under the License.
 // horizontal slices representing the frequencies at one point in time, stacked
 // on top of each other to form a spectrogram showing how those frequencies
 // changed over time.
-class FeatureProvider {
+//
+// The rows are kept as a ring: new slices overwrite the oldest rows in place
+// and the head moves on, rather than every kept row moving up each time. Use
+// CopyWindow to get the spectrogram in time order.
+//
+// The window is FeatureCount slices of FeatureSize features, StrideMs apart.
+// The slices come from AudioFrontend, so FeatureSize and StrideMs have to be
+// the ones it was built with, while FeatureCount can be anything, for
+// windows of different lengths. Each provider has a MicroFeaturesState of
+// its own, so a short and a long window can follow the same audio side by
+// side. Only one task at a time should populate them. Geometries other than
+// FeatureProvider's and ShortFeatureProvider's need explicit instantiations
+// in feature_provider.cc.
+template <int FeatureSize, int FeatureCount, int StrideMs>
+class BasicFeatureProvider {
  public:
-  // Create the provider, and bind it to an area of memory. This memory should
-  // remain accessible for the lifetime of the provider object, since subsequent
-  // calls will fill it with feature data. The provider does no memory
-  // management of this data.
-  FeatureProvider(int feature_size, int8_t* feature_data);
-  ~FeatureProvider();
+  static_assert(FeatureSize == AudioFrontend::kFeatureCount,
+                "The frontend makes slices of AudioFrontend::kFeatureCount "
+                "features");
+  static_assert(StrideMs * kAudioSampleFrequency / 1000 ==
+                    AudioFrontend::kStrideSize,
+                "The frontend makes slices AudioFrontend::kStrideSize "
+                "samples apart");
+  static_assert(FeatureCount >= 1, "The window needs at least one slice");
+
+  static constexpr int kFeatureCount = FeatureCount;
+  static constexpr int kElementCount = FeatureCount * FeatureSize;
+
+  // Create the provider, and bind it to an area of kElementCount bytes. This
+  // memory should remain accessible for the lifetime of the provider object,
+  // since subsequent calls will fill it with feature data. The provider does
+  // no memory management of this data.
+  explicit BasicFeatureProvider(int8_t* feature_data);
 
   // Fills the feature data with information from audio inputs, and returns how
   // many feature slices were updated.
   TfLiteStatus PopulateFeatureData(int32_t last_time_in_ms, int32_t time_in_ms,
                                    int* how_many_new_slices);
 
+  // Returns true if any slice in the current window was computed from audio
+  // with a discontinuity in it, or couldn't be computed at all. Such slices
+  // are blanked, and results from the window shouldn't be trusted. Also true
+  // while a warm started window has too few live slices.
+  bool WindowHasGap() const;
+
+  // Copies the kElementCount features of the window to output, oldest
+  // slice first, in at most two pieces either side of the head.
+  void CopyWindow(int8_t* output) const;
+
+  // Forgets the window, its gap flags and the backlog counters, so the next
+  // PopulateFeatureData starts over as the first one did. For when something
+  // else has used the memory the provider is bound to, like
+  // RunSelfBenchmark.
+  void Restart();
+
+  // Signal statistics of a slice of the window, 0 being the oldest, as
+  // computed along with its features. Slices with gaps have zero stats.
+  const FrontendSliceStats& SliceStats(int slice) const {
+    return slice_stats_[RowOf(slice)];
+  }
+
+  // Features of a slice of the window, 0 being the oldest, and whether it
+  // was blanked or filled in rather than computed from its audio.
+  const int8_t* SliceFeatures(int slice) const {
+    return feature_data_ + RowOf(slice) * FeatureSize;
+  }
+  bool SliceHasGap(int slice) const { return slice_has_gap_[RowOf(slice)]; }
+
+  const FeatureBacklogCounters& BacklogCounters() const {
+    return backlog_counters_;
+  }
+
  private:
-  int feature_size_;
+  // Computes the slices from first_slice to the end of the window from one
+  // fetch of the audio they span, given the step the newest one ends on.
+  // Sets generated to false, without touching any slices, if that audio
+  // can't be fetched in one piece or has a gap in it.
+  TfLiteStatus GenerateSliceBatch(int current_step, int first_slice,
+                                  bool* generated);
+
+  // Fills the rows of slices first_slice to end_slice with
+  // MICRO_FEATURES_CATCH_UP_FILL, and flags them as gaps. Their rows must
+  // still hold the slices they are replacing, as the noise floor is taken
+  // from the whole ring.
+  void SkipSlices(int first_slice, int end_slice);
+
+  // Samples from one slice's window to the next.
+  static constexpr int kStrideSamples = AudioFrontend::kStrideSize;
+
+  // Start of the audio window of a slice in the spectrogram, given the step
+  // that the newest slice ends on.
+  static int32_t SliceStartMs(int current_step, int slice) {
+    const int step = (current_step - FeatureCount + 1) + slice;
+    return (step * StrideMs) - kFeatureDurationMs;
+  }
+
+  // The catch-up and warm start settings, for a window of this length.
+  static constexpr int kCatchUpSlices =
+      (MICRO_FEATURES_CATCH_UP_SLICES < FeatureCount)
+          ? MICRO_FEATURES_CATCH_UP_SLICES
+          : FeatureCount;
+  static constexpr int kWarmStartSlices =
+      (MICRO_FEATURES_WARM_START_SLICES < FeatureCount)
+          ? MICRO_FEATURES_WARM_START_SLICES
+          : FeatureCount;
+
+  // Row of feature_data_ that holds slice, 0 being the oldest.
+  int RowOf(int slice) const {
+    const int row = head_ + slice;
+    return (row < FeatureCount) ? row : row - FeatureCount;
+  }
+
+  // The frontend the slices are computed with, which carries the noise
+  // estimate and overlap from one slice of this window to the next.
+  MicroFeaturesState frontend_state_;
   int8_t* feature_data_;
+  // Row of the oldest slice.
+  int head_;
+  // Slices computed from live audio since the start, up to FeatureCount.
+  int live_slices_;
   // Make sure we don't try to use cached information if this is the first call
   // into the provider.
   bool is_first_run_;
+  // Whether each row was affected by lost audio, and the row's signal
+  // statistics. Indexed by row, like feature_data_.
+  bool slice_has_gap_[FeatureCount];
+  FrontendSliceStats slice_stats_[FeatureCount];
+  // The step of the last slice that was computed, if has_streamed_step_.
+  // The slice after it can be computed from just its newest stride of audio.
+  bool has_streamed_step_;
+  int streamed_step_;
+  FeatureBacklogCounters backlog_counters_;
+#if MICRO_FEATURES_CATCH_UP_FILL == MICRO_FEATURES_CATCH_UP_FILL_NOISE_FLOOR
+  // Features of the quietest slice in the window, taken before it is
+  // overwritten, for filling skipped slices with.
+  int8_t noise_floor_row_[FeatureSize];
+#endif
 };
 
+// The provider for the window micro_model_settings.h describes, which the
+// model takes as its input.
+using FeatureProvider =
+    BasicFeatureProvider<kFeatureSize, kFeatureCount, kFeatureStrideMs>;
+
+// A window of half a second, for models that listen for shorter sounds.
+constexpr int kShortFeatureCount =
+    (kClipDurationMs / 2 - kFeatureDurationMs) / kFeatureStrideMs + 1;
+using ShortFeatureProvider =
+    BasicFeatureProvider<kFeatureSize, kShortFeatureCount, kFeatureStrideMs>;
+
 #endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FEATURE_PROVIDER_H_
@@ -0,0 +1,489 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "frontend_stages.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr int kMaxFftStages = 16;
+// The FFT works in Q15.
+constexpr int kFixedFracBits = 15;
+constexpr int32_t kFixedMax = 32767;
+// PCAN parameters.
+constexpr int kPcanSnrBits = 12;
+constexpr int kPcanOutputBits = 6;
+// Log parameters.
+constexpr int kLogScaleLog2 = 16;
+constexpr uint32_t kLogScale = 1 << kLogScaleLog2;
+constexpr uint32_t kLogCoeff = 45426;  // ln(2) * kLogScale
+
+struct FftStage {
+  int radix;
+  int length;  // Length of each of the radix sub-FFTs combined here.
+  int stride;  // Twiddle stride, also the number of blocks in the stage.
+  const FrontendComplex* twiddles;
+};
+
+FrontendComplex Cexp(double phase) {
+  return {static_cast<int16_t>(floor(.5 + kFixedMax * cos(phase))),
+          static_cast<int16_t>(floor(.5 + kFixedMax * sin(phase)))};
+}
+
+// Fills in the order in which the recursive decimation in time would visit
+// the input, for the sub-FFT starting at stage.
+void FillInputOrder(const FftStage* stages, uint16_t* order, int input,
+                    int stride, int stage) {
+  const int radix = stages[stage].radix;
+  const int length = stages[stage].length;
+  for (int k = 0; k < radix; ++k) {
+    if (length == 1) {
+      order[k] = input;
+    } else {
+      FillInputOrder(stages, order + k * length, input, stride * radix,
+                     stage + 1);
+    }
+    input += stride;
+  }
+}
+
+// The real FFT runs as a complex FFT of half the length, built from radix-4
+// stages plus one radix-2 stage when needed, the same way KISS FFT does it.
+// The stages run iteratively, innermost first, on input that has been put in
+// digit-reversed order. Each stage gets its own copy of the twiddles it uses,
+// in the order it uses them, instead of striding through a shared table.
+template <int FftLength>
+struct FftPlan {
+  static constexpr int kComplexLength = FftLength / 2;
+  static_assert(kComplexLength > 1 &&
+                    (kComplexLength & (kComplexLength - 1)) == 0,
+                "FFT length must be a power of two");
+
+  FftStage stages[kMaxFftStages];
+  int stage_count = 0;
+  uint16_t input_order[kComplexLength];
+  FrontendComplex twiddles[kComplexLength + 1];
+  FrontendComplex rfft_twiddles[kComplexLength / 2];
+
+  FftPlan() {
+    const double pi =
+        3.141592653589793238462643383279502884197169399375105820974944;
+    FrontendComplex shared_twiddles[kComplexLength];
+    for (int i = 0; i < kComplexLength; ++i) {
+      shared_twiddles[i] = Cexp(-2 * pi * i / kComplexLength);
+    }
+    for (int i = 0; i < kComplexLength / 2; ++i) {
+      rfft_twiddles[i] =
+          Cexp(-3.14159265358979323846264338327 *
+               (static_cast<double>(i + 1) / kComplexLength + .5));
+    }
+
+    int n = kComplexLength;
+    int stride = 1;
+    FrontendComplex* stage_twiddles = twiddles;
+    while (n > 1) {
+      FftStage& stage = stages[stage_count++];
+      stage.radix = (n % 4 == 0) ? 4 : 2;
+      n /= stage.radix;
+      stage.length = n;
+      stage.stride = stride;
+      stage.twiddles = stage_twiddles;
+      for (int k = 0; k < stage.length; ++k) {
+        for (int j = 1; j < stage.radix; ++j) {
+          *stage_twiddles++ = shared_twiddles[j * k * stride];
+        }
+      }
+      stride *= stage.radix;
+    }
+    FillInputOrder(stages, input_order, 0, 1, 0);
+  }
+};
+
+// Built the first time an FFT of that length runs.
+template <int FftLength>
+const FftPlan<FftLength>& GetFftPlan() {
+  static const FftPlan<FftLength> plan;
+  return plan;
+}
+
+inline int MostSignificantBit32(uint32_t x) {
+  return x ? 32 - __builtin_clz(x) : 0;
+}
+
+inline int MostSignificantBit64(uint64_t x) {
+  return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+// Q15 helpers. Sums wrap around in 16 bits and products round to nearest, as
+// in KISS FFT's fixed point build.
+inline int16_t Sround(int32_t x) {
+  return static_cast<int16_t>((x + (1 << (kFixedFracBits - 1))) >>
+                              kFixedFracBits);
+}
+
+inline void FixDiv(FrontendComplex* c, int32_t divisor) {
+  c->r = Sround(static_cast<int32_t>(c->r) * (kFixedMax / divisor));
+  c->i = Sround(static_cast<int32_t>(c->i) * (kFixedMax / divisor));
+}
+
+inline FrontendComplex Mul(const FrontendComplex& a, const FrontendComplex& b) {
+  return {Sround(static_cast<int32_t>(a.r) * b.r -
+                 static_cast<int32_t>(a.i) * b.i),
+          Sround(static_cast<int32_t>(a.r) * b.i +
+                 static_cast<int32_t>(a.i) * b.r)};
+}
+
+inline FrontendComplex Add(const FrontendComplex& a, const FrontendComplex& b) {
+  return {static_cast<int16_t>(a.r + b.r), static_cast<int16_t>(a.i + b.i)};
+}
+
+inline FrontendComplex Sub(const FrontendComplex& a, const FrontendComplex& b) {
+  return {static_cast<int16_t>(a.r - b.r), static_cast<int16_t>(a.i - b.i)};
+}
+
+void Butterfly2(FrontendComplex* out, const FrontendComplex* tw, int m) {
+  FrontendComplex* out2 = out + m;
+  for (int k = 0; k < m; ++k) {
+    FixDiv(&out[k], 2);
+    FixDiv(&out2[k], 2);
+    const FrontendComplex t = Mul(out2[k], tw[k]);
+    out2[k] = Sub(out[k], t);
+    out[k] = Add(out[k], t);
+  }
+}
+
+void Butterfly4(FrontendComplex* out, const FrontendComplex* tw, int m) {
+  for (int k = 0; k < m; ++k, tw += 3) {
+    FrontendComplex* f = out + k;
+    FixDiv(&f[0], 4);
+    FixDiv(&f[m], 4);
+    FixDiv(&f[2 * m], 4);
+    FixDiv(&f[3 * m], 4);
+    const FrontendComplex s0 = Mul(f[m], tw[0]);
+    const FrontendComplex s1 = Mul(f[2 * m], tw[1]);
+    const FrontendComplex s2 = Mul(f[3 * m], tw[2]);
+    const FrontendComplex s5 = Sub(f[0], s1);
+    f[0] = Add(f[0], s1);
+    const FrontendComplex s3 = Add(s0, s2);
+    const FrontendComplex s4 = Sub(s0, s2);
+    f[2 * m] = Sub(f[0], s3);
+    f[0] = Add(f[0], s3);
+    f[m].r = static_cast<int16_t>(s5.r + s4.i);
+    f[m].i = static_cast<int16_t>(s5.i - s4.r);
+    f[3 * m].r = static_cast<int16_t>(s5.r - s4.i);
+    f[3 * m].i = static_cast<int16_t>(s5.i + s4.r);
+  }
+}
+
+uint32_t Sqrt64(uint64_t num) {
+  if (num == 0) {
+    return 0;
+  }
+  uint64_t res = 0;
+  int max_bit_number = 64 - MostSignificantBit64(num);
+  max_bit_number |= 1;
+  uint64_t bit = 1ULL << (63 - max_bit_number);
+  while (bit != 0) {
+    if (num >= res + bit) {
+      num -= res + bit;
+      res = (res >> 1) + bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  // Round to nearest, if there's room for it.
+  if (num > res && res != 0xFFFFFFFFLL) {
+    ++res;
+  }
+  return res;
+}
+
+// Gain for a given noise estimate, interpolated from the PCAN lookup table.
+int16_t WideDynamicFunction(uint32_t x, const int16_t* lut) {
+  if (x <= 2) {
+    return lut[x];
+  }
+  const int16_t interval = MostSignificantBit32(x);
+  lut += 4 * interval - 6;
+  const int16_t frac =
+      ((interval < 11) ? (x << (11 - interval)) : (x >> (interval - 11))) &
+      0x3FF;
+  int32_t result = (static_cast<int32_t>(lut[2]) * frac) >> 5;
+  result += static_cast<int32_t>(static_cast<uint32_t>(lut[1]) << 5);
+  result *= frac;
+  result = (result + (1 << 14)) >> 15;
+  result += lut[0];
+  return static_cast<int16_t>(result);
+}
+
+uint32_t PcanShrink(uint32_t x) {
+  if (x < (2 << kPcanSnrBits)) {
+    return (x * x) >> (2 + 2 * kPcanSnrBits - kPcanOutputBits);
+  } else {
+    return (x >> (kPcanSnrBits - kPcanOutputBits)) - (1 << kPcanOutputBits);
+  }
+}
+
+uint32_t Log2FractionPart32(uint32_t x, uint32_t log2x) {
+  // Fractional part of x / 2^log2x, in kLogScale units.
+  int32_t frac = x - (1LL << log2x);
+  if (log2x < kLogScaleLog2) {
+    frac <<= kLogScaleLog2 - log2x;
+  } else {
+    frac >>= log2x - kLogScaleLog2;
+  }
+  // Correct it towards log2(1 + frac) from the lookup table.
+  const uint32_t base_seg = frac >> (kLogScaleLog2 - kFrontendLogSegmentsLog2);
+  const uint32_t seg_unit = kLogScale >> kFrontendLogSegmentsLog2;
+  const int32_t c0 = kFrontendLogLut.values[base_seg];
+  const int32_t c1 = kFrontendLogLut.values[base_seg + 1];
+  const int32_t seg_base = seg_unit * base_seg;
+  const int32_t rel_pos = ((c1 - c0) * (frac - seg_base)) >> kLogScaleLog2;
+  return frac + c0 + rel_pos;
+}
+
+// Natural log of x, times out_scale.
+uint32_t Log32(uint32_t x, uint32_t out_scale) {
+  const uint32_t integer = MostSignificantBit32(x) - 1;
+  const uint32_t fraction = Log2FractionPart32(x, integer);
+  const uint32_t log2 = (integer << kLogScaleLog2) + fraction;
+  const uint32_t round = kLogScale / 2;
+  const uint32_t loge =
+      (static_cast<uint64_t>(kLogCoeff) * log2 + round) >> kLogScaleLog2;
+  return (out_scale * loge + round) >> kLogScaleLog2;
+}
+
+}  // namespace
+
+int16_t FrontendApplyWindow(const int16_t* input, const int16_t* weights,
+                            int size, int shift, int16_t* output) {
+  int16_t max_abs = 0;
+  for (int i = 0; i < size; ++i) {
+    int32_t value = (static_cast<int32_t>(input[i]) * weights[i]) >> shift;
+    if (value < INT16_MIN) {
+      value = INT16_MIN;
+    } else if (value > INT16_MAX) {
+      value = INT16_MAX;
+    }
+    output[i] = value;
+    if (output[i] > max_abs) {
+      max_abs = output[i];
+    } else if (-output[i] > max_abs) {
+      max_abs = -output[i];
+    }
+  }
+  return max_abs;
+}
+
+int FrontendFftAutoScale(int16_t* data, int size, int16_t max_abs) {
+  int scale_bits = 15 - MostSignificantBit32(max_abs);
+  if (scale_bits <= 0) {
+    return 0;
+  }
+  for (int i = 0; i < size; ++i) {
+    data[i] = data[i] << scale_bits;
+  }
+  return scale_bits;
+}
+
+template <int FftLength>
+void FrontendRfft(const int16_t* input, FrontendComplex* scratch,
+                  FrontendComplex* output) {
+  constexpr int kComplexFftLength = FftLength / 2;
+  const FftPlan<FftLength>& plan = GetFftPlan<FftLength>();
+  const FrontendComplex* samples =
+      reinterpret_cast<const FrontendComplex*>(input);
+  for (int i = 0; i < kComplexFftLength; ++i) {
+    scratch[i] = samples[plan.input_order[i]];
+  }
+  for (int s = plan.stage_count - 1; s >= 0; --s) {
+    const FftStage& stage = plan.stages[s];
+    const int block = stage.radix * stage.length;
+    for (int b = 0; b < stage.stride; ++b) {
+      if (stage.radix == 4) {
+        Butterfly4(scratch + b * block, stage.twiddles, stage.length);
+      } else {
+        Butterfly2(scratch + b * block, stage.twiddles, stage.length);
+      }
+    }
+  }
+
+  // Split the half-length complex FFT into the bins of the real one.
+  FrontendComplex tdc = scratch[0];
+  FixDiv(&tdc, 2);
+  output[0].r = tdc.r + tdc.i;
+  output[kComplexFftLength].r = tdc.r - tdc.i;
+  output[kComplexFftLength].i = output[0].i = 0;
+  for (int k = 1; k <= kComplexFftLength / 2; ++k) {
+    FrontendComplex fpk = scratch[k];
+    FrontendComplex fpnk;
+    fpnk.r = scratch[kComplexFftLength - k].r;
+    fpnk.i = -scratch[kComplexFftLength - k].i;
+    FixDiv(&fpk, 2);
+    FixDiv(&fpnk, 2);
+    const FrontendComplex f1k = Add(fpk, fpnk);
+    const FrontendComplex f2k = Sub(fpk, fpnk);
+    const FrontendComplex tw = Mul(f2k, plan.rfft_twiddles[k - 1]);
+    output[k].r = (f1k.r + tw.r) >> 1;
+    output[k].i = (f1k.i + tw.i) >> 1;
+    output[kComplexFftLength - k].r = (f1k.r - tw.r) >> 1;
+    output[kComplexFftLength - k].i = (tw.i - f1k.i) >> 1;
+  }
+}
+
+template void FrontendRfft<DefaultFrontendGeometry::kFftLength>(
+    const int16_t* input, FrontendComplex* scratch, FrontendComplex* output);
+
+void FrontendSpectrumToEnergy(const FrontendComplex* input, int start,
+                              int end, uint32_t* output) {
+  for (int i = start; i < end; ++i) {
+    const int16_t real = input[i].r;
+    const int16_t imag = input[i].i;
+    output[i] = (static_cast<uint32_t>(real) * real) +
+                (static_cast<uint32_t>(imag) * imag);
+  }
+}
+
+void FrontendTrimFilterbank(const FrontendFilterbank& filterbank,
+                            int16_t* channel_frequency_starts,
+                            int16_t* channel_weight_starts,
+                            int16_t* channel_widths) {
+  for (int i = 0; i < filterbank.num_channels + 1; ++i) {
+    const int weight_start = filterbank.channel_weight_starts[i];
+    int first = 0;
+    int last = filterbank.channel_widths[i];
+    while (first < last && filterbank.weights[weight_start + first] == 0 &&
+           filterbank.unweights[weight_start + first] == 0) {
+      ++first;
+    }
+    while (last > first && filterbank.weights[weight_start + last - 1] == 0 &&
+           filterbank.unweights[weight_start + last - 1] == 0) {
+      --last;
+    }
+    channel_frequency_starts[i] =
+        filterbank.channel_frequency_starts[i] + first;
+    channel_weight_starts[i] = weight_start + first;
+    channel_widths[i] = last - first;
+  }
+}
+
+void FrontendFilterbankAccumulate(const FrontendFilterbank& filterbank,
+                                  const uint32_t* input, uint64_t* output) {
+  uint64_t weight_accumulator = 0;
+  uint64_t unweight_accumulator = 0;
+  for (int i = 0; i < filterbank.num_channels + 1; ++i) {
+    const uint32_t* energy = input + filterbank.channel_frequency_starts[i];
+    const int16_t* weights =
+        filterbank.weights + filterbank.channel_weight_starts[i];
+    const int16_t* unweights =
+        filterbank.unweights + filterbank.channel_weight_starts[i];
+    const int width = filterbank.channel_widths[i];
+    for (int j = 0; j < width; ++j) {
+      weight_accumulator += weights[j] * static_cast<uint64_t>(energy[j]);
+      unweight_accumulator += unweights[j] * static_cast<uint64_t>(energy[j]);
+    }
+    output[i] = weight_accumulator;
+    weight_accumulator = unweight_accumulator;
+    unweight_accumulator = 0;
+  }
+}
+
+void FrontendFilterbankSqrt(const uint64_t* input, int num_channels,
+                            int scale_down_bits, uint32_t* output) {
+  for (int i = 0; i < num_channels; ++i) {
+    output[i] = Sqrt64(input[i]) >> scale_down_bits;
+  }
+}
+
+void FrontendFilterbankLog(const uint32_t* input, int num_channels,
+                           uint32_t output_scale, int correction_bits,
+                           int16_t* output) {
+  for (int i = 0; i < num_channels; ++i) {
+    const uint32_t scaled = input[i] << correction_bits;
+    if (scaled > 1) {
+      const uint32_t log_value = Log32(scaled, output_scale);
+      output[i] = (log_value < static_cast<uint32_t>(INT16_MAX)) ? log_value
+                                                                 : INT16_MAX;
+    } else {
+      output[i] = 0;
+    }
+  }
+}
+
+void FrontendPcan(const int16_t* gain_lut, int snr_shift,
+                  const uint32_t* noise_estimate, uint32_t* signal,
+                  int num_channels) {
+  for (int i = 0; i < num_channels; ++i) {
+    const uint32_t gain = WideDynamicFunction(noise_estimate[i], gain_lut);
+    const uint32_t snr =
+        (static_cast<uint64_t>(signal[i]) * gain) >> snr_shift;
+    signal[i] = PcanShrink(snr);
+  }
+}
+
+void FrontendDct(const int16_t* input, int num_channels, const int16_t* dct,
+                 int dct_bits, int num_coefficients, int output_shift,
+                 int8_t* output) {
+  const int shift = dct_bits + output_shift;
+  const int32_t rounding = 1 << (shift - 1);
+  for (int k = 0; k < num_coefficients; ++k) {
+    // Log channels stay below 1500, so 32 bits hold the sum comfortably.
+    int32_t sum = rounding;
+    for (int n = 0; n < num_channels; ++n) {
+      sum += input[n] * dct[n];
+    }
+    int32_t value = sum >> shift;
+    if (value > INT8_MAX) {
+      value = INT8_MAX;
+    } else if (value < INT8_MIN) {
+      value = INT8_MIN;
+    }
+    output[k] = value;
+    dct += num_channels;
+  }
+}
+
+int FrontendCountClipped(const int16_t* input, int size) {
+  int count = 0;
+  for (int i = 0; i < size; ++i) {
+    count += (input[i] == INT16_MAX) || (input[i] == INT16_MIN);
+  }
+  return count;
+}
+
+void FrontendSliceStatistics(const uint32_t* channels,
+                             const uint32_t* noise_estimate, int noise_bits,
+                             int num_channels, FrontendSliceStats* stats) {
+  // ln(x) * 64 of both sums, and 20 / ln(10) / 64 as 139 / 1024.
+  constexpr uint32_t kLogScale = 64;
+  constexpr int32_t kDbScale = 139;
+  constexpr int kDbShift = 10;
+  uint32_t sums[2] = {0, 0};
+  for (int i = 0; i < num_channels; ++i) {
+    sums[0] += channels[i];
+    sums[1] += noise_estimate[i] >> noise_bits;
+  }
+  stats->energy = sums[0];
+  stats->noise_floor = sums[1];
+  if (sums[0] <= 1 || sums[1] <= 1) {
+    stats->snr_db = 0;
+    return;
+  }
+  int16_t logs[2];
+  FrontendFilterbankLog(sums, 2, kLogScale, 0, logs);
+  stats->snr_db = ((logs[0] - logs[1]) * kDbScale) >> kDbShift;
+}
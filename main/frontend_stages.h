@@ -0,0 +1,121 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FRONTEND_STAGES_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FRONTEND_STAGES_H_
+
+#include <cstdint>
+
+#include "audio_frontend_tables.h"
+
+// The individual stages of the audio frontend. Each one computes exactly what
+// the signal kernel of the same name computes, so they can be used both by
+// AudioFrontend and as drop-in kernels for the preprocessor model.
+
+struct FrontendComplex {
+  int16_t r;
+  int16_t i;
+};
+
+// Mel filterbank layout, as described in audio_frontend_tables.h.
+struct FrontendFilterbank {
+  int num_channels;
+  const int16_t* weights;
+  const int16_t* unweights;
+  const int16_t* channel_frequency_starts;
+  const int16_t* channel_weight_starts;
+  const int16_t* channel_widths;
+};
+
+// Signal statistics of one slice, gathered while computing its features.
+// Energy and noise are summed over the filterbank channels, in the units of
+// the channels after the square root stage.
+struct FrontendSliceStats {
+  // The channels before spectral subtraction.
+  uint32_t energy;
+  // The spectral subtraction's noise estimate from the slices before.
+  uint32_t noise_floor;
+  // 20 log10(energy / noise_floor), or 0 while either is still 0.
+  int16_t snr_db;
+  // Samples of the window at either end of the int16 range.
+  uint16_t clipped_samples;
+};
+
+// Multiplies size samples by weights and shifts them down, saturating to
+// int16. Returns the largest magnitude in the output.
+int16_t FrontendApplyWindow(const int16_t* input, const int16_t* weights,
+                            int size, int shift, int16_t* output);
+
+// Shifts data up in place so that max_abs, its largest magnitude, uses all 15
+// bits. Returns how many bits it was shifted by.
+int FrontendFftAutoScale(int16_t* data, int size, int16_t max_abs);
+
+// Real FFT of FftLength samples into FftLength / 2 + 1 bins. scratch must
+// have room for FftLength / 2 values. frontend_stages.cc instantiates it for
+// the FFT length of DefaultFrontendGeometry.
+template <int FftLength>
+void FrontendRfft(const int16_t* input, FrontendComplex* scratch,
+                  FrontendComplex* output);
+
+// Squared magnitude of bins start to end - 1. Other bins are left untouched.
+void FrontendSpectrumToEnergy(const FrontendComplex* input, int start,
+                              int end, uint32_t* output);
+
+// Writes the start and width of each channel with its leading and trailing
+// zero weights left out, so that FrontendFilterbankAccumulate skips them.
+// The filterbanks in the tables pad every channel to a multiple of 4 bins.
+void FrontendTrimFilterbank(const FrontendFilterbank& filterbank,
+                            int16_t* channel_frequency_starts,
+                            int16_t* channel_weight_starts,
+                            int16_t* channel_widths);
+
+// Accumulates the energy into num_channels + 1 channels. Channel 0 only
+// collects the unweights of the first bins and isn't normally used.
+void FrontendFilterbankAccumulate(const FrontendFilterbank& filterbank,
+                                  const uint32_t* input, uint64_t* output);
+
+// Square root of each channel, shifted down by scale_down_bits.
+void FrontendFilterbankSqrt(const uint64_t* input, int num_channels,
+                            int scale_down_bits, uint32_t* output);
+
+// Natural log of each channel shifted up by correction_bits, times
+// output_scale, saturating to int16. Channels of 0 or 1 give 0.
+void FrontendFilterbankLog(const uint32_t* input, int num_channels,
+                           uint32_t output_scale, int correction_bits,
+                           int16_t* output);
+
+// PCAN auto gain control of signal, in place, driven by the noise estimate.
+void FrontendPcan(const int16_t* gain_lut, int snr_shift,
+                  const uint32_t* noise_estimate, uint32_t* signal,
+                  int num_channels);
+
+// Number of the size samples that are at INT16_MIN or INT16_MAX.
+int FrontendCountClipped(const int16_t* input, int size);
+
+// Fills in everything but the clipped samples of stats from the channels
+// and the noise estimate going into spectral subtraction, which is scaled up
+// by noise_bits.
+void FrontendSliceStatistics(const uint32_t* channels,
+                             const uint32_t* noise_estimate, int noise_bits,
+                             int num_channels, FrontendSliceStats* stats);
+
+// Multiplies the num_channels log channels by the num_coefficients rows of a
+// DCT matrix with dct_bits fraction bits, and saturates each coefficient,
+// rounded and shifted down by output_shift, to int8.
+void FrontendDct(const int16_t* input, int num_channels, const int16_t* dct,
+                 int dct_bits, int num_coefficients, int output_shift,
+                 int8_t* output);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_FRONTEND_STAGES_H_
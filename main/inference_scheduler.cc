@@ -0,0 +1,100 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "inference_scheduler.h"
+
+#include "micro_model_settings.h"
+
+namespace {
+
+static_assert(MICRO_SPEECH_MAX_INFERENCE_INTERVAL >= 1,
+              "The model has to run at least every few slices");
+
+constexpr int kMaxInterval = MICRO_SPEECH_MAX_INFERENCE_INTERVAL;
+// Quiet slices before each step up in the interval.
+constexpr int kBackoffStepSlices = 500 / kFeatureStrideMs;
+// Categories from this one on are keywords. The first two are silence and
+// unknown, which steady background scores on as well.
+constexpr int kFirstKeywordCategory = 2;
+// A keyword scoring this much is taken as one being spoken.
+constexpr float kKeywordActivityScore = 0.3f;
+
+}  // namespace
+
+InferenceScheduler::InferenceScheduler()
+    : quiet_slices_(0), pending_slices_(0), invoke_us_x8_(0), counters_() {
+  counters_.interval = 1;
+  counters_.min_interval = 1;
+}
+
+bool InferenceScheduler::ShouldInvoke(int new_slices, int peak_snr_db) {
+  if (new_slices <= 0) {
+    return false;
+  }
+  counters_.slices += new_slices;
+  pending_slices_ += new_slices;
+  if (peak_snr_db >= MICRO_SPEECH_VAD_SNR_DB) {
+    quiet_slices_ = 0;
+  } else {
+    quiet_slices_ += new_slices;
+  }
+
+  int interval = 1 + quiet_slices_ / kBackoffStepSlices;
+  if (interval < counters_.min_interval) {
+    interval = counters_.min_interval;
+  }
+  if (interval > kMaxInterval) {
+    interval = kMaxInterval;
+  }
+  counters_.interval = interval;
+
+  if (pending_slices_ < interval) {
+    ++counters_.skipped_invokes;
+    return false;
+  }
+  pending_slices_ = 0;
+  ++counters_.invokes;
+  return true;
+}
+
+void InferenceScheduler::InvokeDone(const TfLiteTensor* scores,
+                                    int32_t invoke_us) {
+  const float scale = scores->params.scale;
+  const int zero_point = scores->params.zero_point;
+  for (int i = kFirstKeywordCategory; i < kCategoryCount; ++i) {
+    if ((scores->data.int8[i] - zero_point) * scale >=
+        kKeywordActivityScore) {
+      quiet_slices_ = 0;
+    }
+  }
+
+  // The first time seeds the average, after that each one counts for an
+  // eighth.
+  if (invoke_us_x8_ == 0) {
+    invoke_us_x8_ = invoke_us * 8;
+  } else {
+    invoke_us_x8_ += invoke_us - invoke_us_x8_ / 8;
+  }
+  // The least interval whose audio takes long enough for Invoke to stay
+  // within its share of it.
+  const int64_t budget_us_x8 = static_cast<int64_t>(kFeatureStrideMs) * 1000 *
+                               MICRO_SPEECH_INFERENCE_LOAD_PERCENT * 8 / 100;
+  int min_interval = 1;
+  while (min_interval < kMaxInterval &&
+         invoke_us_x8_ > budget_us_x8 * min_interval) {
+    ++min_interval;
+  }
+  counters_.min_interval = min_interval;
+}
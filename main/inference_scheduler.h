@@ -0,0 +1,79 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_INFERENCE_SCHEDULER_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_INFERENCE_SCHEDULER_H_
+
+// The most new slices the model may go without running. The window changes
+// little from one slice to the next, so in steady background the model only
+// runs every few slices. 1 runs it on every slice.
+#ifndef MICRO_SPEECH_MAX_INFERENCE_INTERVAL
+#define MICRO_SPEECH_MAX_INFERENCE_INTERVAL 4
+#endif
+
+// A slice this far above the frontend's noise estimate is taken as speech.
+#ifndef MICRO_SPEECH_VAD_SNR_DB
+#define MICRO_SPEECH_VAD_SNR_DB 6
+#endif
+
+// The share of the audio's time Invoke may take. When it takes more, the
+// model never runs more often than keeps it under this.
+#ifndef MICRO_SPEECH_INFERENCE_LOAD_PERCENT
+#define MICRO_SPEECH_INFERENCE_LOAD_PERCENT 50
+#endif
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+struct InferenceSchedulerCounters {
+  // Slices the model runs on, at most: 1 while speech or a keyword is
+  // around, or the least the CPU allows.
+  int interval;
+  // The least interval Invoke's time allows.
+  int min_interval;
+  uint32_t slices;
+  uint32_t invokes;
+  // Calls to ShouldInvoke with new slices that returned false.
+  uint32_t skipped_invokes;
+};
+
+// Decides which windows the model runs on. Speech in the new slices or a
+// keyword in the last scores puts it back to running on every window, and
+// the interval then grows a step at a time while neither comes back.
+class InferenceScheduler {
+ public:
+  InferenceScheduler();
+
+  // Call with the slices PopulateFeatureData computed and the highest SNR
+  // among them. Returns true if the model should run on the window.
+  bool ShouldInvoke(int new_slices, int peak_snr_db);
+
+  // Call after each Invoke with its output and how long it took.
+  void InvokeDone(const TfLiteTensor* scores, int32_t invoke_us);
+
+  const InferenceSchedulerCounters& Counters() const { return counters_; }
+
+ private:
+  // Slices since the last speech or keyword.
+  int quiet_slices_;
+  // Slices since the model last ran.
+  int pending_slices_;
+  // Average Invoke time, in 1/8 us.
+  int32_t invoke_us_x8_;
+  InferenceSchedulerCounters counters_;
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_INFERENCE_SCHEDULER_H_
@@ -31,6 +31,9 @@ void tf_main(void) {
 }
 
 extern "C" void app_main() {
-  xTaskCreate((TaskFunction_t)&tf_main, "tensorflow", 8 * 1024, NULL, 8, NULL);
+  // Keep inference on core 0, so that core 1 is free for the feature
+  // generator's slice worker when it catches up.
+  xTaskCreatePinnedToCore((TaskFunction_t)&tf_main, "tensorflow", 8 * 1024,
+                          NULL, 8, NULL, 0);
   vTaskDelete(NULL);
 }
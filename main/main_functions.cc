@@ -23,23 +23,31 @@ limitations under the License.
 // Original micro_speech includes
 #include "main_functions.h"
 #include "audio_provider.h"
+#include "benchmarks.h"
 // #include "command_responder.h" // <<< Removed: As requested, logic moved inline
+#include "feature_log.h"
 #include "feature_provider.h"
+#include "inference_scheduler.h"
 #include "micro_model_settings.h"
 #include "model.h"
+#include "model_loader.h"
 #include "recognize_commands.h"
+#include "self_benchmark.h"
 
 // Original TF Lite Micro includes
 #include "tensorflow/lite/micro/system_setup.h" // <<< Added back: Standard TFLM setup call
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_resource_variable.h"
 
 // <<< --- Start: Added System Includes (for USB and Task Delay) --- >>>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include "esp_log.h" // Already used by MicroPrintf, but good to be explicit if adding more logs
 // <<< --- End: Added System Includes --- >>>
 
@@ -57,9 +65,14 @@ const tflite::Model* model = nullptr;
 tflite::MicroInterpreter* interpreter = nullptr;
 TfLiteTensor* model_input = nullptr;
 FeatureProvider* feature_provider = nullptr;
+InferenceScheduler* inference_scheduler = nullptr;
 RecognizeCommands* recognizer = nullptr;
 int32_t previous_time = 0;
 
+#if MICRO_SPEECH_MODEL_SOURCE == MICRO_SPEECH_MODEL_PARTITION
+constexpr char kModelPartitionLabel[] = "model";
+#endif
+
 // Create an area of memory to use for input, output, and intermediate arrays.
 // The size of this will depend on the model you're using, and may need to be
 // determined by experimentation.
@@ -90,22 +103,17 @@ void setup() {
   }
   // <<< --- End: USB Host Serial Initialization --- >>>
 
-  // Map the model into a usable data structure. This doesn't involve any
-  // copying or parsing, it's a very lightweight operation.
-  model = tflite::GetModel(g_model);
-  if (model->version() != TFLITE_SCHEMA_VERSION) {
-    MicroPrintf("Model provided is schema version %d not equal to supported "
-                "version %d.", model->version(), TFLITE_SCHEMA_VERSION);
-    return;
-  }
-
   // Pull in only the operation implementations we need.
   // This relies on a complete list of all the ops needed by this graph.
   // An easier approach is to just use the AllOpsResolver, but this will
   // incur some penalty in code space for op implementations that are not
   // needed by this graph.
   // NOLINTNEXTLINE(runtime-global-variables)
+#if MICRO_SPEECH_STREAMING_MODEL
+  static tflite::MicroMutableOpResolver<10> micro_op_resolver;
+#else
   static tflite::MicroMutableOpResolver<4> micro_op_resolver;
+#endif
   if (micro_op_resolver.AddDepthwiseConv2D() != kTfLiteOk) {
       MicroPrintf("Failed AddDepthwiseConv2D"); // Added log
       return;
@@ -122,10 +130,63 @@ void setup() {
       MicroPrintf("Failed AddReshape"); // Added log
       return;
   }
+#if MICRO_SPEECH_STREAMING_MODEL
+  // A streaming model sets up its state variables once, reads and assigns
+  // them on every Invoke, and appends the newest slice to the slices it
+  // keeps of each layer's input, dropping the oldest.
+  if ((micro_op_resolver.AddCallOnce() != kTfLiteOk) ||
+      (micro_op_resolver.AddVarHandle() != kTfLiteOk) ||
+      (micro_op_resolver.AddReadVariable() != kTfLiteOk) ||
+      (micro_op_resolver.AddAssignVariable() != kTfLiteOk) ||
+      (micro_op_resolver.AddConcatenation() != kTfLiteOk) ||
+      (micro_op_resolver.AddStridedSlice() != kTfLiteOk)) {
+    MicroPrintf("Failed to add the streaming model's ops");
+    return;
+  }
+#endif
+
+  // Map the model into a usable data structure. This doesn't involve any
+  // copying, the flatbuffer is only checked before it's used in place.
+#if MICRO_SPEECH_MODEL_SOURCE == MICRO_SPEECH_MODEL_PARTITION
+  static MappedModel mapped_model;
+  if (MapModel(kModelPartitionLabel, &mapped_model) != kTfLiteOk) {
+    return;
+  }
+  const uint8_t* model_data = mapped_model.data;
+  const size_t model_size = mapped_model.size;
+#else
+  const uint8_t* model_data = g_model;
+  const size_t model_size = g_model_len;
+#endif
+  if (ValidateModel(model_data, model_size, micro_op_resolver, &model) !=
+      kTfLiteOk) {
+    return;
+  }
 
   // Build an interpreter to run the model with.
+#if MICRO_SPEECH_STREAMING_MODEL
+  // The resource variables live in the arena too, so the allocator is made
+  // first and shared with the interpreter.
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(tensor_arena, kTensorArenaSize);
+  if (allocator == nullptr) {
+    MicroPrintf("MicroAllocator::Create() failed");
+    return;
+  }
+  tflite::MicroResourceVariables* resource_variables =
+      tflite::MicroResourceVariables::Create(allocator,
+                                             MICRO_SPEECH_STREAMING_VARIABLES);
+  if (resource_variables == nullptr) {
+    MicroPrintf("Couldn't allocate %d resource variables",
+                MICRO_SPEECH_STREAMING_VARIABLES);
+    return;
+  }
+  static tflite::MicroInterpreter static_interpreter(
+      model, micro_op_resolver, allocator, resource_variables);
+#else
   static tflite::MicroInterpreter static_interpreter(
       model, micro_op_resolver, tensor_arena, kTensorArenaSize);
+#endif
   interpreter = &static_interpreter;
 
   // Allocate memory from the tensor_arena for the model's tensors.
@@ -136,27 +197,36 @@ void setup() {
   }
 
   // Get information about the memory area to use for the model's input.
+  // ValidateModel has checked that it matches the feature type and size
+  // micro_model_settings.h selects.
   model_input = interpreter->input(0);
-  if ((model_input->dims->size != 2) || (model_input->dims->data[0] != 1) ||
-      (model_input->dims->data[1] !=
-       (kFeatureCount * kFeatureSize)) ||
-      (model_input->type != kTfLiteInt8)) {
-    MicroPrintf("Bad input tensor parameters in model");
-    return;
-  }
   model_input_buffer = tflite::GetTensorData<int8_t>(model_input);
 
   // Prepare to access the audio spectrograms from a microphone or other source
   // that will provide the inputs to the neural network.
   // NOLINTNEXTLINE(runtime-global-variables)
-  static FeatureProvider static_feature_provider(kFeatureElementCount,
-                                                 feature_buffer);
+  static FeatureProvider static_feature_provider(feature_buffer);
   feature_provider = &static_feature_provider;
 
   static RecognizeCommands static_recognizer;
   recognizer = &static_recognizer;
 
+  static InferenceScheduler static_inference_scheduler;
+  inference_scheduler = &static_inference_scheduler;
+
+#if MICRO_SPEECH_FEATURE_LOG
+  if (FeatureLogStart() != kTfLiteOk) {
+    MicroPrintf("Running without the feature log");
+  }
+#endif
+
   previous_time = 0;
+#if MICRO_SPEECH_RUN_BENCHMARKS
+  RunBenchmarks();
+#endif
+#if MICRO_SPEECH_SELF_BENCHMARK
+  RunSelfBenchmark(interpreter);
+#endif
   MicroPrintf("--- Micro Speech setup() finished ---"); // Added log
 }
 
@@ -171,6 +241,15 @@ void loop() {
   }
   // <<< --- End: Check USB Connection --- >>>
 
+#if MICRO_SPEECH_SELF_BENCHMARK
+  // The self-benchmark leaves the frontend and the model's input in its own
+  // state, so the window is built again from scratch.
+  if (SelfBenchmarkRequested()) {
+    RunSelfBenchmark(interpreter);
+    feature_provider->Restart();
+  }
+#endif
+
   // Fetch the spectrogram for the current time.
   const int32_t current_time = LatestAudioTimestamp();
   int how_many_new_slices = 0;
@@ -189,13 +268,61 @@ void loop() {
       return;
   }
 
-  // Copy feature buffer to input tensor
-  for (int i = 0; i < kFeatureElementCount; i++) {
-    model_input_buffer[i] = feature_buffer[i];
+#if MICRO_SPEECH_FEATURE_LOG
+  // Each new slice is logged once, stamped with the time its window ends.
+  const int32_t newest_slice_ms =
+      (current_time / kFeatureStrideMs) * kFeatureStrideMs;
+  for (int slice = kFeatureCount - how_many_new_slices; slice < kFeatureCount;
+       ++slice) {
+    FeatureLogRow(newest_slice_ms - (kFeatureCount - 1 - slice) *
+                                        kFeatureStrideMs,
+                  feature_provider->SliceFeatures(slice),
+                  feature_provider->SliceHasGap(slice));
+  }
+#endif
+
+#if MICRO_SPEECH_STREAMING_MODEL
+  // A streaming model sees each slice only once, so it runs on every new
+  // one, oldest first, and the last run's scores are the window's. When the
+  // window was built afresh, the state it kept no longer leads up to it.
+  if (how_many_new_slices == kFeatureCount) {
+    interpreter->Reset();
+  }
+  TfLiteStatus invoke_status = kTfLiteOk;
+  for (int slice = kFeatureCount - how_many_new_slices;
+       (slice < kFeatureCount) && (invoke_status == kTfLiteOk); ++slice) {
+    memcpy(model_input_buffer, feature_provider->SliceFeatures(slice),
+           kFeatureSize);
+    invoke_status = interpreter->Invoke();
+  }
+  if (invoke_status != kTfLiteOk) {
+    MicroPrintf( "Invoke failed");
+    return;
+  }
+
+  TfLiteTensor* output = interpreter->output(0);
+#else
+  // Skip the model on this window unless the scheduler wants it.
+  int peak_snr_db = 0;
+  for (int slice = kFeatureCount - how_many_new_slices; slice < kFeatureCount;
+       ++slice) {
+    if (!feature_provider->SliceHasGap(slice) &&
+        feature_provider->SliceStats(slice).snr_db > peak_snr_db) {
+      peak_snr_db = feature_provider->SliceStats(slice).snr_db;
+    }
   }
+  if (!inference_scheduler->ShouldInvoke(how_many_new_slices, peak_snr_db)) {
+    return;
+  }
+
+  // Copy the spectrogram to the input tensor, oldest slice first.
+  feature_provider->CopyWindow(model_input_buffer);
 
   // Run the model on the spectrogram input and make sure it succeeds.
+  const int64_t invoke_start_us = esp_timer_get_time();
   TfLiteStatus invoke_status = interpreter->Invoke();
+  const int32_t invoke_us =
+      static_cast<int32_t>(esp_timer_get_time() - invoke_start_us);
   if (invoke_status != kTfLiteOk) {
     MicroPrintf( "Invoke failed");
     return;
@@ -203,6 +330,11 @@ void loop() {
 
   // Obtain a pointer to the output tensor
   TfLiteTensor* output = interpreter->output(0);
+  inference_scheduler->InvokeDone(output, invoke_us);
+#endif
+#if MICRO_SPEECH_FEATURE_LOG
+  FeatureLogScores(current_time, tflite::GetTensorData<int8_t>(output));
+#endif
 
   // <<< --- Start: Modified Result Processing --- >>>
   // Using the RecognizeCommands class to get smooth results and command strings.
@@ -211,7 +343,8 @@ void loop() {
   float score = 0;
   bool is_new_command = false;
   TfLiteStatus process_status = recognizer->ProcessLatestResults(
-      output, current_time, &found_command, &score, &is_new_command);
+      output, current_time, feature_provider->WindowHasGap(), &found_command,
+      &score, &is_new_command);
   if (process_status != kTfLiteOk) {
     MicroPrintf("RecognizeCommands::ProcessLatestResults() failed");
     return;
@@ -221,6 +354,25 @@ void loop() {
   // Only send a command if a new command was recognized this cycle.
   if (is_new_command) {
       MicroPrintf("New command: %s, Score: %.2f", found_command, static_cast<double>(score)); // Log recognized command
+      const FrontendSliceStats& stats =
+          feature_provider->SliceStats(kFeatureCount - 1);
+      MicroPrintf("Latest slice: SNR %d dB, %d clipped samples",
+                  stats.snr_db, stats.clipped_samples);
+      const FeatureBacklogCounters& backlog =
+          feature_provider->BacklogCounters();
+      MicroPrintf("Slice backlog: %d (max %d), %u slices skipped",
+                  backlog.backlog, backlog.max_backlog,
+                  static_cast<unsigned>(backlog.skipped_slices));
+#if !MICRO_SPEECH_STREAMING_MODEL
+      const InferenceSchedulerCounters& schedule =
+          inference_scheduler->Counters();
+      MicroPrintf("Inference every %d slices (at least %d), %u of %u "
+                  "slices invoked, %u invokes skipped",
+                  schedule.interval, schedule.min_interval,
+                  static_cast<unsigned>(schedule.invokes),
+                  static_cast<unsigned>(schedule.slices),
+                  static_cast<unsigned>(schedule.skipped_invokes));
+#endif
 
       // Define command JSON strings (using format from Elegoo-AI-Robot)
       uint8_t yes_cmd[] = "{'H':'Elegoo','N':1,'D1':0,'D2':50,'D3':1}"; // Forward command
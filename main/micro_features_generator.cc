@@ -17,34 +17,103 @@ limitations under the License.
 
 #include <cmath>
 #include <cstring>
+#include <new>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "audio_frontend.h"
+#include "benchmarks.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "micro_model_settings.h"
+
+// The interpreter is only needed for the preprocessor model, so builds
+// without it, like the host tests, don't need the TFLM kernels.
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL
 #include "audio_preprocessor_int8_model_data.h"
+#include "signal_kernels.h"
 #include "tensorflow/lite/schema/schema_generated.h"
-#include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include "tensorflow/lite/micro/micro_log.h"
-#include "micro_model_settings.h"
+#endif
 
 namespace {
 
 // FrontendState g_micro_features_state;
 bool g_is_first_time = true;
 
+// The state of the functions that don't take one.
+MicroFeaturesState g_state;
+
+#if MICRO_FEATURES_PARALLEL_SLICES
+// Batches smaller than this aren't worth waking the worker for.
+constexpr int kMinParallelSlices = 4;
+constexpr BaseType_t kWorkerCore = 1;
+constexpr uint32_t kWorkerStackSize = 3 * 1024;
+constexpr UBaseType_t kWorkerPriority = 8;
+
+// The windows the worker computes the channels of, one row each.
+struct ChannelJob {
+  const int16_t* audio;
+  int slice_count;
+  uint32_t (*channels)[AudioFrontend::kChannelCount];
+};
+
+// The worker has a frontend of its own for the scratch buffers, but only
+// ever runs its stateless half. The noise estimate stays with the state the
+// slices are generated with.
+AudioFrontend g_worker_frontend;
+ChannelJob g_worker_job;
+TaskHandle_t g_worker_task = nullptr;
+SemaphoreHandle_t g_worker_start = nullptr;
+SemaphoreHandle_t g_worker_done = nullptr;
+
+// The channels of every slice of a batch, filled in by both cores. Longer
+// batches are split into runs of this many.
+constexpr int kMaxParallelSlices = kFeatureCount;
+uint32_t g_slice_channels[kMaxParallelSlices][AudioFrontend::kChannelCount];
+
+void ComputeChannels(AudioFrontend& frontend, const ChannelJob& job) {
+  for (int i = 0; i < job.slice_count; ++i) {
+    frontend.ComputeChannels(job.audio + i * kAudioSampleStrideCount,
+                             job.channels[i]);
+  }
+}
+
+void SliceWorker(void* arg) {
+  while (true) {
+    xSemaphoreTake(g_worker_start, portMAX_DELAY);
+    ComputeChannels(g_worker_frontend, g_worker_job);
+    xSemaphoreGive(g_worker_done);
+  }
+}
+#endif
+
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL
 const tflite::Model* model = nullptr;
-tflite::MicroInterpreter* interpreter = nullptr;
 
 constexpr size_t kArenaSize = 16 * 1024;
-alignas(16) uint8_t g_arena[kArenaSize];
 
-constexpr int kAudioSampleDurationCount =
-    kFeatureDurationMs * kAudioSampleFrequency / 1000;
-constexpr int kAudioSampleStrideCount =
-    kFeatureStrideMs * kAudioSampleFrequency / 1000;
 using AudioPreprocessorOpResolver = tflite::MicroMutableOpResolver<18>;
+
+// One reference interpreter per set of signal kernels, each with its own
+// arena. MicroFeaturesState's interpreters share the op resolvers.
+struct ReferenceModel {
+  AudioPreprocessorOpResolver op_resolver;
+  bool has_ops = false;
+#if MICRO_SPEECH_RUN_BENCHMARKS
+  OpProfiler profiler;
+#endif
+  tflite::MicroInterpreter* interpreter = nullptr;
+};
+ReferenceModel g_reference_models[kSignalKernelsCount];
+#endif
 }  // namespace
 
-TfLiteStatus RegisterOps(AudioPreprocessorOpResolver& op_resolver) {
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL
+TfLiteStatus RegisterOps(AudioPreprocessorOpResolver& op_resolver,
+                         SignalKernels kernels) {
   TF_LITE_ENSURE_STATUS(op_resolver.AddReshape());
   TF_LITE_ENSURE_STATUS(op_resolver.AddCast());
   TF_LITE_ENSURE_STATUS(op_resolver.AddStridedSlice());
@@ -54,20 +123,36 @@ TfLiteStatus RegisterOps(AudioPreprocessorOpResolver& op_resolver) {
   TF_LITE_ENSURE_STATUS(op_resolver.AddDiv());
   TF_LITE_ENSURE_STATUS(op_resolver.AddMinimum());
   TF_LITE_ENSURE_STATUS(op_resolver.AddMaximum());
-  TF_LITE_ENSURE_STATUS(op_resolver.AddWindow());
+  if (kernels == SignalKernels::kFast) {
+    TF_LITE_ENSURE_STATUS(
+        op_resolver.AddCustom("SignalWindow", Register_FAST_WINDOW()));
+    TF_LITE_ENSURE_STATUS(
+        op_resolver.AddCustom("SignalRfft", Register_FAST_RFFT()));
+    TF_LITE_ENSURE_STATUS(
+        op_resolver.AddCustom("SignalEnergy", Register_FAST_ENERGY()));
+    TF_LITE_ENSURE_STATUS(
+        op_resolver.AddCustom("SignalFilterBank", Register_FAST_FILTER_BANK()));
+    TF_LITE_ENSURE_STATUS(op_resolver.AddCustom(
+        "SignalFilterBankLog", Register_FAST_FILTER_BANK_LOG()));
+  } else {
+    TF_LITE_ENSURE_STATUS(op_resolver.AddWindow());
+    TF_LITE_ENSURE_STATUS(op_resolver.AddRfft());
+    TF_LITE_ENSURE_STATUS(op_resolver.AddEnergy());
+    TF_LITE_ENSURE_STATUS(op_resolver.AddFilterBank());
+    TF_LITE_ENSURE_STATUS(op_resolver.AddFilterBankLog());
+  }
   TF_LITE_ENSURE_STATUS(op_resolver.AddFftAutoScale());
-  TF_LITE_ENSURE_STATUS(op_resolver.AddRfft());
-  TF_LITE_ENSURE_STATUS(op_resolver.AddEnergy());
-  TF_LITE_ENSURE_STATUS(op_resolver.AddFilterBank());
   TF_LITE_ENSURE_STATUS(op_resolver.AddFilterBankSquareRoot());
   TF_LITE_ENSURE_STATUS(op_resolver.AddFilterBankSpectralSubtraction());
   TF_LITE_ENSURE_STATUS(op_resolver.AddPCAN());
-  TF_LITE_ENSURE_STATUS(op_resolver.AddFilterBankLog());
   return kTfLiteOk;
 }
 
-TfLiteStatus InitializeMicroFeatures() {
-  g_is_first_time = true;
+// Builds an interpreter of the preprocessor model, with an arena of its own,
+// registering the ops for kernels the first time.
+static TfLiteStatus CreateInterpreter(
+    SignalKernels kernels, tflite::MicroInterpreter** interpreter_output) {
+  ReferenceModel& reference = g_reference_models[static_cast<int>(kernels)];
 
   // Map the model into a usable data structure. This doesn't involve any
   // copying or parsing, it's a very lightweight operation.
@@ -78,16 +163,38 @@ TfLiteStatus InitializeMicroFeatures() {
     return kTfLiteError;
   }
 
-  static AudioPreprocessorOpResolver op_resolver;
-  RegisterOps(op_resolver);
+  if (!reference.has_ops) {
+    TF_LITE_ENSURE_STATUS(RegisterOps(reference.op_resolver, kernels));
+    reference.has_ops = true;
+  }
 
-  static tflite::MicroInterpreter static_interpreter(model, op_resolver, g_arena, kArenaSize);
-  interpreter = &static_interpreter;
+  uint8_t* arena = static_cast<uint8_t*>(heap_caps_aligned_alloc(
+      16, kArenaSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+  void* interpreter_buffer = heap_caps_malloc(
+      sizeof(tflite::MicroInterpreter), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (arena == nullptr || interpreter_buffer == nullptr) {
+    MicroPrintf("Could not allocate the Feature generator arena");
+    heap_caps_free(arena);
+    heap_caps_free(interpreter_buffer);
+    return kTfLiteError;
+  }
+#if MICRO_SPEECH_RUN_BENCHMARKS
+  tflite::MicroProfilerInterface* profiler = &reference.profiler;
+#else
+  tflite::MicroProfilerInterface* profiler = nullptr;
+#endif
+  tflite::MicroInterpreter* new_interpreter =
+      new (interpreter_buffer) tflite::MicroInterpreter(
+          model, reference.op_resolver, arena, kArenaSize, nullptr, profiler);
 
-  if (interpreter->AllocateTensors() != kTfLiteOk) {
+  if (new_interpreter->AllocateTensors() != kTfLiteOk) {
     MicroPrintf("AllocateTensors failed for Feature provider model. Line %d", __LINE__);
+    new_interpreter->~MicroInterpreter();
+    heap_caps_free(interpreter_buffer);
+    heap_caps_free(arena);
     return kTfLiteError;
   }
+  *interpreter_output = new_interpreter;
 
   // MicroPrintf("AudioPreprocessor model arena size = %u",
   //             interpreter.arena_used_bytes());
@@ -95,16 +202,37 @@ TfLiteStatus InitializeMicroFeatures() {
   return kTfLiteOk;
 }
 
+static TfLiteStatus InitializeReferenceModel(
+    SignalKernels kernels, tflite::MicroInterpreter** interpreter_output) {
+  ReferenceModel& reference = g_reference_models[static_cast<int>(kernels)];
+  if (reference.interpreter == nullptr) {
+    TF_LITE_ENSURE_STATUS(CreateInterpreter(kernels, &reference.interpreter));
+  }
+  *interpreter_output = reference.interpreter;
+  return kTfLiteOk;
+}
+
+#if MICRO_SPEECH_RUN_BENCHMARKS
+OpProfiler& ReferenceModelProfiler(SignalKernels kernels) {
+  return g_reference_models[static_cast<int>(kernels)].profiler;
+}
+#endif
+
 TfLiteStatus GenerateSingleFeature(const int16_t* audio_data,
                                    const int audio_data_size,
                                    int8_t* feature_output,
                                    tflite::MicroInterpreter* interpreter) {
+  // The memory planner places the input and output tensors in the arena and
+  // reuses their space for other tensors during Invoke, so they can't be
+  // pointed at the caller's buffers and the data has to be copied in and out.
+  // The native frontend reads and writes the caller's buffers directly.
   TfLiteTensor* input = interpreter->input(0);
   TfLiteTensor* output = interpreter->output(0);
   std::copy_n(audio_data, audio_data_size,
               tflite::GetTensorData<int16_t>(input));
   if (interpreter->Invoke() != kTfLiteOk) {
     MicroPrintf("Feature generator model invocation failed");
+    return kTfLiteError;
   }
 
   std::copy_n(tflite::GetTensorData<int8_t>(output), kFeatureSize,
@@ -113,9 +241,13 @@ TfLiteStatus GenerateSingleFeature(const int16_t* audio_data,
   return kTfLiteOk;
 }
 
-TfLiteStatus GenerateFeatures(const int16_t* audio_data,
-                              const size_t audio_data_size,
-                              Features* features_output) {
+TfLiteStatus GenerateReferenceFeatures(const int16_t* audio_data,
+                                       const size_t audio_data_size,
+                                       Features* features_output,
+                                       SignalKernels kernels) {
+  tflite::MicroInterpreter* interpreter = nullptr;
+  TF_LITE_ENSURE_STATUS(InitializeReferenceModel(kernels, &interpreter));
+  interpreter->Reset();
   size_t remaining_samples = audio_data_size;
   size_t feature_index = 0;
   while (remaining_samples >= kAudioSampleDurationCount &&
@@ -130,3 +262,177 @@ TfLiteStatus GenerateFeatures(const int16_t* audio_data,
 
   return kTfLiteOk;
 }
+#endif  // MICRO_FEATURES_HAVE_REFERENCE_MODEL
+
+#if MICRO_FEATURES_PARALLEL_SLICES
+static TfLiteStatus StartSliceWorker() {
+  if (g_worker_task != nullptr) {
+    return kTfLiteOk;
+  }
+  g_worker_start = xSemaphoreCreateBinary();
+  g_worker_done = xSemaphoreCreateBinary();
+  if (g_worker_start == nullptr || g_worker_done == nullptr) {
+    MicroPrintf("Could not create the slice worker's semaphores");
+    return kTfLiteError;
+  }
+  if (xTaskCreatePinnedToCore(SliceWorker, "slice_worker", kWorkerStackSize,
+                              nullptr, kWorkerPriority, &g_worker_task,
+                              kWorkerCore) != pdPASS) {
+    MicroPrintf("Could not start the slice worker");
+    g_worker_task = nullptr;
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+// Hands the later half of the windows to the worker and computes the
+// channels of the earlier half meanwhile. Once both are done, the rest of
+// the stages run over the slices in order, so the features come out the
+// same as from ProcessSlices. At most kMaxParallelSlices at a time.
+static void GenerateSlicesOnBothCores(AudioFrontend& frontend,
+                                      const int16_t* audio_data,
+                                      int slice_count,
+                                      int8_t* features_output,
+                                      FrontendSliceStats* stats_output) {
+  const int local_count = slice_count / 2;
+  g_worker_job = {audio_data + local_count * kAudioSampleStrideCount,
+                  slice_count - local_count, g_slice_channels + local_count};
+  xSemaphoreGive(g_worker_start);
+  ComputeChannels(frontend, {audio_data, local_count, g_slice_channels});
+  xSemaphoreTake(g_worker_done, portMAX_DELAY);
+
+  for (int i = 0; i < slice_count; ++i) {
+    FrontendSliceStats* stats =
+        (stats_output != nullptr) ? &stats_output[i] : nullptr;
+    frontend.ChannelsToFeatures(g_slice_channels[i], features_output, stats);
+    if (stats != nullptr) {
+      stats->clipped_samples = FrontendCountClipped(
+          audio_data + i * kAudioSampleStrideCount, kAudioSampleDurationCount);
+    }
+    features_output += kFeatureSize;
+  }
+  frontend.KeepOverlap(audio_data +
+                       (slice_count - 1) * kAudioSampleStrideCount);
+}
+#endif
+
+TfLiteStatus InitializeMicroFeatures(MicroFeaturesState* state) {
+  state->frontend.Reset();
+#if MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+  if (state->interpreter == nullptr) {
+    TF_LITE_ENSURE_STATUS(
+        CreateInterpreter(kDefaultSignalKernels, &state->interpreter));
+  }
+  state->interpreter->Reset();
+  state->has_overlap = false;
+#endif
+#if MICRO_FEATURES_PARALLEL_SLICES
+  TF_LITE_ENSURE_STATUS(StartSliceWorker());
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus InitializeMicroFeatures() {
+  g_is_first_time = true;
+  return InitializeMicroFeatures(&g_state);
+}
+
+TfLiteStatus GenerateFeatures(const int16_t* audio_data,
+                              const size_t audio_data_size,
+                              Features* features_output) {
+  if (audio_data_size < kAudioSampleDurationCount) {
+    return kTfLiteOk;
+  }
+  int slice_count =
+      (audio_data_size - kAudioSampleDurationCount) / kAudioSampleStrideCount +
+      1;
+  if (slice_count > kFeatureCount) {
+    slice_count = kFeatureCount;
+  }
+  return GenerateFeatureSlices(audio_data, slice_count, (*features_output)[0]);
+}
+
+TfLiteStatus GenerateFeatureSlices(MicroFeaturesState* state,
+                                   const int16_t* audio_data, int slice_count,
+                                   int8_t* features_output,
+                                   FrontendSliceStats* stats_output) {
+#if MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+  // The model doesn't expose its intermediate tensors.
+  if (stats_output != nullptr) {
+    memset(stats_output, 0, slice_count * sizeof(FrontendSliceStats));
+  }
+  for (int i = 0; i < slice_count; ++i) {
+    TF_LITE_ENSURE_STATUS(GenerateSingleFeature(
+        audio_data, kAudioSampleDurationCount, features_output,
+        state->interpreter));
+    std::copy_n(audio_data + kAudioSampleStrideCount,
+                AudioFrontend::kOverlapCount, state->stride_window);
+    state->has_overlap = true;
+    audio_data += kAudioSampleStrideCount;
+    features_output += kFeatureSize;
+  }
+#else
+#if MICRO_FEATURES_PARALLEL_SLICES
+  if (slice_count >= kMinParallelSlices && g_worker_task != nullptr) {
+    while (slice_count > 0) {
+      const int run_count = (slice_count < kMaxParallelSlices)
+                                ? slice_count
+                                : kMaxParallelSlices;
+      GenerateSlicesOnBothCores(state->frontend, audio_data, run_count,
+                                features_output, stats_output);
+      audio_data += run_count * kAudioSampleStrideCount;
+      features_output += run_count * kFeatureSize;
+      if (stats_output != nullptr) {
+        stats_output += run_count;
+      }
+      slice_count -= run_count;
+    }
+    return kTfLiteOk;
+  }
+#endif
+  state->frontend.ProcessSlices(audio_data, slice_count, features_output,
+                                stats_output);
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus GenerateFeatureSlices(const int16_t* audio_data, int slice_count,
+                                   int8_t* features_output,
+                                   FrontendSliceStats* stats_output) {
+  return GenerateFeatureSlices(&g_state, audio_data, slice_count,
+                               features_output, stats_output);
+}
+
+TfLiteStatus GenerateStrideFeatures(MicroFeaturesState* state,
+                                    const int16_t* stride_data,
+                                    int8_t* feature_output,
+                                    FrontendSliceStats* stats_output) {
+#if MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+  if (stats_output != nullptr) {
+    memset(stats_output, 0, sizeof(*stats_output));
+  }
+  if (state->has_overlap) {
+    std::copy_n(stride_data, kAudioSampleStrideCount,
+                state->stride_window + AudioFrontend::kOverlapCount);
+    TF_LITE_ENSURE_STATUS(GenerateSingleFeature(
+        state->stride_window, kAudioSampleDurationCount, feature_output,
+        state->interpreter));
+    std::copy_n(state->stride_window + kAudioSampleStrideCount,
+                AudioFrontend::kOverlapCount, state->stride_window);
+    return kTfLiteOk;
+  }
+#else
+  if (state->frontend.PushStride(stride_data, feature_output, stats_output)) {
+    return kTfLiteOk;
+  }
+#endif
+  MicroPrintf("No previous window to continue the stride from");
+  return kTfLiteError;
+}
+
+TfLiteStatus GenerateStrideFeatures(const int16_t* stride_data,
+                                    int8_t* feature_output,
+                                    FrontendSliceStats* stats_output) {
+  return GenerateStrideFeatures(&g_state, stride_data, feature_output,
+                                stats_output);
+}
@@ -16,12 +16,98 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_MICRO_FEATURES_MICRO_FEATURES_GENERATOR_H_
 #define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_MICRO_FEATURES_MICRO_FEATURES_GENERATOR_H_
 
+#include <sdkconfig.h>
+
+#include "audio_frontend.h"
+#include "frontend_stages.h"
 #include "tensorflow/lite/c/common.h"
 #include "micro_model_settings.h"
 
+// Features are computed by the native AudioFrontend. Set this to 1 to run the
+// preprocessor model through the TFLM interpreter instead, as before.
+#ifndef MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+#define MICRO_FEATURES_USE_PREPROCESSOR_MODEL 0
+#endif
+
+// The preprocessor model computes 40 channels of log mel features with the
+// default frontend settings, nothing else.
+#define MICRO_FEATURES_MATCH_PREPROCESSOR_MODEL                          \
+  (MICRO_FEATURES_TYPE == MICRO_FEATURES_LOG_MEL &&                      \
+   MICRO_FEATURES_CHANNEL_COUNT == 40 &&                                 \
+   MICRO_FEATURES_DURATION_MS == 30 && MICRO_FEATURES_STRIDE_MS == 20 && \
+   MICRO_FEATURES_PCAN && MICRO_FEATURES_NOISE_SMOOTHING == 25 &&        \
+   MICRO_FEATURES_NOISE_ALTERNATE_SMOOTHING == 60)
+#if MICRO_FEATURES_USE_PREPROCESSOR_MODEL && \
+    !MICRO_FEATURES_MATCH_PREPROCESSOR_MODEL
+#error "The preprocessor model only computes the default log mel features"
+#endif
+
+// The preprocessor model is only built in when it's used, or when the
+// benchmarks need it to check the native frontend against. This header
+// doesn't include benchmarks.h, where MICRO_SPEECH_RUN_BENCHMARKS is set,
+// so the files that build or call the reference model include it first.
+#define MICRO_FEATURES_HAVE_REFERENCE_MODEL \
+  (MICRO_FEATURES_USE_PREPROCESSOR_MODEL || \
+   (MICRO_SPEECH_RUN_BENCHMARKS && MICRO_FEATURES_MATCH_PREPROCESSOR_MODEL))
+
+// When the preprocessor model is used, run its window, FFT, energy and
+// filterbank ops with the kernels from signal_kernels.h rather than the stock
+// ones. Set this to 0 to go back to the stock kernels.
+#ifndef MICRO_FEATURES_FAST_SIGNAL_KERNELS
+#define MICRO_FEATURES_FAST_SIGNAL_KERNELS 1
+#endif
+
+// On dual core chips, GenerateFeatureSlices has a worker task on core 1
+// compute the stateless stages of half of the windows, while the calling task
+// does the other half. Set this to 0 to compute every slice on the calling
+// task. Streaming one stride at a time is the same either way.
+#ifndef MICRO_FEATURES_PARALLEL_SLICES
+#if CONFIG_FREERTOS_UNICORE || MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+#define MICRO_FEATURES_PARALLEL_SLICES 0
+#else
+#define MICRO_FEATURES_PARALLEL_SLICES 1
+#endif
+#endif
+
+// Which kernels the preprocessor model's signal ops are registered with.
+enum class SignalKernels {
+  kStock,
+  kFast,
+};
+constexpr int kSignalKernelsCount = 2;
+constexpr SignalKernels kDefaultSignalKernels =
+    MICRO_FEATURES_FAST_SIGNAL_KERNELS ? SignalKernels::kFast
+                                       : SignalKernels::kStock;
+
 using Features = int8_t[kFeatureCount][kFeatureSize];
 
-// Sets up any resources needed for the feature generation pipeline.
+#if MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+namespace tflite {
+class MicroInterpreter;
+}
+#endif
+
+// Everything one stream of slices carries from a slice to the next: the
+// frontend's noise estimate and the audio the next window shares with the
+// last, and its scratch buffers. Each feature provider has its own, so
+// several can follow the same audio without disturbing each other. The
+// functions without a state argument use one the generator keeps.
+struct MicroFeaturesState {
+  AudioFrontend frontend;
+#if MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+  // The model keeps its noise estimate in its own variable tensors, so each
+  // state gets an interpreter and arena of its own on first use. The model
+  // needs whole windows, so strides are joined onto the end of the last
+  // window's overlap here.
+  tflite::MicroInterpreter* interpreter = nullptr;
+  int16_t stride_window[kAudioSampleDurationCount];
+  bool has_overlap = false;
+#endif
+};
+
+// Sets up any resources needed for the feature generation pipeline, and
+// starts state over from a fresh noise estimate.
+TfLiteStatus InitializeMicroFeatures(MicroFeaturesState* state);
 TfLiteStatus InitializeMicroFeatures();
 
 // Converts audio sample data into a more compact form that's appropriate for
@@ -34,4 +120,51 @@ TfLiteStatus GenerateFeatures(const int16_t* audio_data,
                               const size_t audio_data_size,
                               Features* features_output);
 
+// Computes slice_count consecutive slices from one contiguous span of audio
+// in a single pass, writing them to slice_count rows of kFeatureSize
+// features. audio_data must hold the (slice_count - 1) strides and the
+// window that they span. Cheaper than one call per slice when catching up,
+// and split over both cores with MICRO_FEATURES_PARALLEL_SLICES. If
+// stats_output is given, it gets the FrontendSliceStats of each slice. They
+// are all zero when the preprocessor model computes the features. The
+// worker task is shared by every state, so only one task at a time should
+// generate features.
+TfLiteStatus GenerateFeatureSlices(MicroFeaturesState* state,
+                                   const int16_t* audio_data, int slice_count,
+                                   int8_t* features_output,
+                                   FrontendSliceStats* stats_output = nullptr);
+TfLiteStatus GenerateFeatureSlices(const int16_t* audio_data, int slice_count,
+                                   int8_t* features_output,
+                                   FrontendSliceStats* stats_output = nullptr);
+
+// Streaming counterpart of GenerateFeatures. Computes the features of the
+// window that ends with the kAudioSampleStrideCount samples in stride_data,
+// which must follow straight on from the audio of the last window passed to
+// either function with the same state since InitializeMicroFeatures. Only
+// the new samples are read, the rest of the window is kept from before.
+TfLiteStatus GenerateStrideFeatures(MicroFeaturesState* state,
+                                    const int16_t* stride_data,
+                                    int8_t* feature_output,
+                                    FrontendSliceStats* stats_output = nullptr);
+TfLiteStatus GenerateStrideFeatures(const int16_t* stride_data,
+                                    int8_t* feature_output,
+                                    FrontendSliceStats* stats_output = nullptr);
+
+#if MICRO_FEATURES_HAVE_REFERENCE_MODEL
+// Same as GenerateFeatures, but always runs the preprocessor model, starting
+// from a fresh noise estimate. Used to check the native frontend. Each set
+// of kernels gets its own interpreter, built on first use.
+TfLiteStatus GenerateReferenceFeatures(
+    const int16_t* audio_data, const size_t audio_data_size,
+    Features* features_output,
+    SignalKernels kernels = kDefaultSignalKernels);
+
+#if MICRO_SPEECH_RUN_BENCHMARKS
+class OpProfiler;
+
+// The per op timings of the interpreter for `kernels`.
+OpProfiler& ReferenceModelProfiler(SignalKernels kernels);
+#endif
+#endif
+
 #endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_MICRO_FEATURES_MICRO_FEATURES_GENERATOR_H_
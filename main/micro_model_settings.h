@@ -20,11 +20,81 @@ limitations under the License.
 // If you change the way you preprocess the input, update all these constants.
 constexpr int kMaxAudioSampleSize = 512;
 constexpr int kAudioSampleFrequency = 16000;
-constexpr int kFeatureSize = 40;
-constexpr int kFeatureCount = 49;
+
+// The features computed for each slice. MICRO_FEATURES_LOG_MEL is the PCAN
+// log mel filterbank the models were trained on, one feature per channel.
+// MICRO_FEATURES_MFCC takes the DCT of the same log channels and keeps the
+// first MICRO_FEATURES_MFCC_COUNT coefficients, for smaller input models.
+#define MICRO_FEATURES_LOG_MEL 0
+#define MICRO_FEATURES_MFCC 1
+#ifndef MICRO_FEATURES_TYPE
+#define MICRO_FEATURES_TYPE MICRO_FEATURES_LOG_MEL
+#endif
+#ifndef MICRO_FEATURES_CHANNEL_COUNT
+#define MICRO_FEATURES_CHANNEL_COUNT 40
+#endif
+#ifndef MICRO_FEATURES_MFCC_COUNT
+#define MICRO_FEATURES_MFCC_COUNT 13
+#endif
+
+// Mel filterbank channels, and the features the model sees per slice.
+constexpr int kFilterbankChannelCount = MICRO_FEATURES_CHANNEL_COUNT;
+#if MICRO_FEATURES_TYPE == MICRO_FEATURES_MFCC
+constexpr int kFeatureSize = MICRO_FEATURES_MFCC_COUNT;
+#else
+constexpr int kFeatureSize = kFilterbankChannelCount;
+#endif
+
+// Window length and stride of each slice. tools/frontend_sweep.py overrides
+// these and the frontend parameters below to measure what changing them
+// costs; the models here were trained on the defaults.
+#ifndef MICRO_FEATURES_DURATION_MS
+#define MICRO_FEATURES_DURATION_MS 30
+#endif
+#ifndef MICRO_FEATURES_STRIDE_MS
+#define MICRO_FEATURES_STRIDE_MS 20
+#endif
+constexpr int kFeatureStrideMs = MICRO_FEATURES_STRIDE_MS;
+constexpr int kFeatureDurationMs = MICRO_FEATURES_DURATION_MS;
+// Slices that fit in the one second clips the models see at a time.
+constexpr int kClipDurationMs = 1000;
+constexpr int kFeatureCount =
+    (kClipDurationMs - kFeatureDurationMs) / kFeatureStrideMs + 1;
 constexpr int kFeatureElementCount = (kFeatureSize * kFeatureCount);
-constexpr int kFeatureStrideMs = 20;
-constexpr int kFeatureDurationMs = 30;
+
+// Set to 1 for a streaming model, which keeps what it needs of earlier
+// slices in resource variables and takes only the newest slice on each
+// Invoke, instead of the whole window. The model in model.cc is not one.
+// MICRO_SPEECH_STREAMING_VARIABLES is how many variables it may hold.
+#ifndef MICRO_SPEECH_STREAMING_MODEL
+#define MICRO_SPEECH_STREAMING_MODEL 0
+#endif
+#ifndef MICRO_SPEECH_STREAMING_VARIABLES
+#define MICRO_SPEECH_STREAMING_VARIABLES 8
+#endif
+// The int8 features of one model input.
+#if MICRO_SPEECH_STREAMING_MODEL
+constexpr int kModelInputElementCount = kFeatureSize;
+#else
+constexpr int kModelInputElementCount = kFeatureElementCount;
+#endif
+
+// PCAN auto gain control on or off, and how fast the spectral subtraction's
+// noise estimate follows even and odd channels, in thousandths per slice.
+#ifndef MICRO_FEATURES_PCAN
+#define MICRO_FEATURES_PCAN 1
+#endif
+#ifndef MICRO_FEATURES_NOISE_SMOOTHING
+#define MICRO_FEATURES_NOISE_SMOOTHING 25
+#endif
+#ifndef MICRO_FEATURES_NOISE_ALTERNATE_SMOOTHING
+#define MICRO_FEATURES_NOISE_ALTERNATE_SMOOTHING 60
+#endif
+// Audio samples in one feature window, and new samples per feature stride.
+constexpr int kAudioSampleDurationCount =
+    kFeatureDurationMs * kAudioSampleFrequency / 1000;
+constexpr int kAudioSampleStrideCount =
+    kFeatureStrideMs * kAudioSampleFrequency / 1000;
 
 // Variables for the model's output categories.
 constexpr int kCategoryCount = 4;
@@ -0,0 +1,169 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "model_loader.h"
+
+#include "micro_model_settings.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef ESP_PLATFORM
+
+TfLiteStatus MapModel(const char* name, MappedModel* mapped) {
+  const esp_partition_t* partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+  if (partition == nullptr) {
+    MicroPrintf("No \"%s\" partition for the model", name);
+    return kTfLiteError;
+  }
+  // The model's size isn't known until it's read, so the whole partition
+  // is mapped. That only takes data cache MMU pages, not memory.
+  const void* data = nullptr;
+  esp_partition_mmap_handle_t handle;
+  const esp_err_t err = esp_partition_mmap(
+      partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &data, &handle);
+  if (err != ESP_OK) {
+    MicroPrintf("Couldn't map the \"%s\" partition: %s", name,
+                esp_err_to_name(err));
+    return kTfLiteError;
+  }
+  mapped->data = static_cast<const uint8_t*>(data);
+  mapped->size = partition->size;
+  mapped->handle = handle;
+  return kTfLiteOk;
+}
+
+void UnmapModel(MappedModel* mapped) {
+  if (mapped->data != nullptr) {
+    esp_partition_munmap(mapped->handle);
+    mapped->data = nullptr;
+  }
+}
+
+#else  // ESP_PLATFORM
+
+TfLiteStatus MapModel(const char* name, MappedModel* mapped) {
+  const int fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    MicroPrintf("Couldn't open %s", name);
+    return kTfLiteError;
+  }
+  struct stat file_stat;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  if (data == MAP_FAILED) {
+    MicroPrintf("Couldn't map %s", name);
+    close(fd);
+    return kTfLiteError;
+  }
+  mapped->data = static_cast<const uint8_t*>(data);
+  mapped->size = file_stat.st_size;
+  mapped->handle = fd;
+  return kTfLiteOk;
+}
+
+void UnmapModel(MappedModel* mapped) {
+  if (mapped->data != nullptr) {
+    munmap(const_cast<uint8_t*>(mapped->data), mapped->size);
+    close(mapped->handle);
+    mapped->data = nullptr;
+  }
+}
+
+#endif  // ESP_PLATFORM
+
+TfLiteStatus ValidateModel(const uint8_t* data, size_t size,
+                           const tflite::MicroOpResolver& op_resolver,
+                           const tflite::Model** model) {
+  // An erased partition fails here rather than in the verifier.
+  if (size < 8 || !tflite::ModelBufferHasIdentifier(data)) {
+    MicroPrintf("No TensorFlow Lite model found");
+    return kTfLiteError;
+  }
+  flatbuffers::Verifier verifier(data, size);
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    MicroPrintf("The model is corrupt");
+    return kTfLiteError;
+  }
+  const tflite::Model* candidate = tflite::GetModel(data);
+  if (candidate->version() != TFLITE_SCHEMA_VERSION) {
+    MicroPrintf("Model provided is schema version %d not equal to supported "
+                "version %d.", candidate->version(), TFLITE_SCHEMA_VERSION);
+    return kTfLiteError;
+  }
+
+  const auto* op_codes = candidate->operator_codes();
+  for (uint32_t i = 0; op_codes != nullptr && i < op_codes->size(); ++i) {
+    const tflite::OperatorCode* op_code = op_codes->Get(i);
+    const tflite::BuiltinOperator builtin = tflite::GetBuiltinCode(op_code);
+    if (builtin == tflite::BuiltinOperator_CUSTOM) {
+      const char* name = (op_code->custom_code() != nullptr)
+                             ? op_code->custom_code()->c_str()
+                             : "";
+      if (op_resolver.FindOp(name) == nullptr) {
+        MicroPrintf("The model uses custom op %s, which isn't registered",
+                    name);
+        return kTfLiteError;
+      }
+    } else if (op_resolver.FindOp(builtin) == nullptr) {
+      MicroPrintf("The model uses op %s, which isn't registered",
+                  tflite::EnumNameBuiltinOperator(builtin));
+      return kTfLiteError;
+    }
+  }
+
+  // The first subgraph is the one Invoke runs.
+  const auto* subgraphs = candidate->subgraphs();
+  if (subgraphs == nullptr || subgraphs->size() == 0 ||
+      subgraphs->Get(0)->inputs() == nullptr ||
+      subgraphs->Get(0)->inputs()->size() != 1) {
+    MicroPrintf("The model should have a single input");
+    return kTfLiteError;
+  }
+  const tflite::SubGraph* subgraph = subgraphs->Get(0);
+  const int input_index = subgraph->inputs()->Get(0);
+  if (subgraph->tensors() == nullptr || input_index < 0 ||
+      static_cast<uint32_t>(input_index) >= subgraph->tensors()->size()) {
+    MicroPrintf("The model's input tensor is missing");
+    return kTfLiteError;
+  }
+  const tflite::Tensor* input = subgraph->tensors()->Get(input_index);
+  int elements = 1;
+  for (uint32_t d = 0; input->shape() != nullptr && d < input->shape()->size();
+       ++d) {
+    elements *= input->shape()->Get(d);
+  }
+  if (input->type() != tflite::TensorType_INT8 ||
+      elements != kModelInputElementCount) {
+    MicroPrintf("The model takes %d %s inputs, not %d int8 features",
+                elements, tflite::EnumNameTensorType(input->type()),
+                kModelInputElementCount);
+    return kTfLiteError;
+  }
+
+  *model = candidate;
+  return kTfLiteOk;
+}
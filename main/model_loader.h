@@ -0,0 +1,65 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_MODEL_LOADER_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_MODEL_LOADER_H_
+
+// Where setup() gets the model from. MICRO_SPEECH_MODEL_PARTITION maps the
+// "model" flash partition, which idf.py flash writes main/model.tflite to,
+// so a new model only needs
+//
+//   esptool.py write_flash 0x110000 new_model.tflite
+//
+// at the partition's offset in partitions.csv, and g_model is left out of
+// the app. MICRO_SPEECH_MODEL_EMBEDDED uses g_model from model.cc.
+#define MICRO_SPEECH_MODEL_EMBEDDED 0
+#define MICRO_SPEECH_MODEL_PARTITION 1
+#ifndef MICRO_SPEECH_MODEL_SOURCE
+#define MICRO_SPEECH_MODEL_SOURCE MICRO_SPEECH_MODEL_PARTITION
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+// A read-only view of a .tflite file, used in place without a copy.
+struct MappedModel {
+  const uint8_t* data;
+  // The bytes mapped, which can be more than the model takes.
+  size_t size;
+  // What unmapping needs: the partition mmap handle on the device, the file
+  // descriptor on the host.
+  uint32_t handle;
+};
+
+// Maps the model named by name: the label of a flash data partition on the
+// device, and the path of a .tflite file on the host. The partition is
+// mapped through the flash cache, so reading it costs no RAM but is slower
+// than internal SRAM until the cache has it.
+TfLiteStatus MapModel(const char* name, MappedModel* mapped);
+void UnmapModel(MappedModel* mapped);
+
+// Checks that data holds a TensorFlow Lite model of the schema version this
+// build reads, that op_resolver has every op it uses, and that its input
+// takes the kModelInputElementCount int8 features micro_model_settings.h
+// describes, before anything is allocated for it. Sets model on success.
+TfLiteStatus ValidateModel(const uint8_t* data, size_t size,
+                           const tflite::MicroOpResolver& op_resolver,
+                           const tflite::Model** model);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_MODEL_LOADER_H_
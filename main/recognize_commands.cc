@@ -32,7 +32,8 @@ RecognizeCommands::RecognizeCommands(int32_t average_window_duration_ms,
 
 TfLiteStatus RecognizeCommands::ProcessLatestResults(
     const TfLiteTensor* latest_results, const int32_t current_time_ms,
-    const char** found_command, float* score, bool* is_new_command) {
+    bool input_has_gap, const char** found_command, float* score,
+    bool* is_new_command) {
   if ((latest_results->dims->size != 2) ||
       (latest_results->dims->data[0] != 1) ||
       (latest_results->dims->data[1] != kCategoryCount)) {
@@ -126,7 +127,9 @@ TfLiteStatus RecognizeCommands::ProcessLatestResults(
   } else {
     time_since_last_top = current_time_ms - previous_top_label_time_;
   }
-  if ((current_top_score > detection_threshold_) &&
+  // Spliced audio can look like a command that was never spoken, so don't
+  // fire on a window with a gap in it.
+  if (!input_has_gap && (current_top_score > detection_threshold_) &&
       ((current_top_label != previous_top_label_) ||
        (time_since_last_top > suppression_ms_))) {
     previous_top_label_ = current_top_label;
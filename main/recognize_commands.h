@@ -129,9 +129,12 @@ class RecognizeCommands {
                              int32_t suppression_ms = 1500,
                              int32_t minimum_count = 3);
 
-  // Call this with the results of running a model on sample data.
+  // Call this with the results of running a model on sample data. If the
+  // input window spanned a gap in the audio, pass true for input_has_gap: the
+  // scores still feed the average, but no new command is reported for them.
   TfLiteStatus ProcessLatestResults(const TfLiteTensor* latest_results,
                                     const int32_t current_time_ms,
+                                    bool input_has_gap,
                                     const char** found_command, float* score,
                                     bool* is_new_command);
 
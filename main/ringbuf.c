@@ -30,24 +30,82 @@ limitations under the License.
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #define RB_TAG "RINGBUF"
 
 ringbuf_t* rb_init(const char* name, uint32_t size) {
+#if (CONFIG_SPIRAM_SUPPORT && \
+     (CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC))
+  return rb_init_caps(name, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+  return rb_init_caps(name, size, MALLOC_CAP_DEFAULT);
+#endif
+}
+
+ringbuf_t* rb_init_caps(const char* name, uint32_t size, uint32_t caps) {
+  return rb_init_mirrored(name, size, 0, caps);
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+/**
+ * Map the same pages twice in a row, so that base[size + i] is base[i].
+ * Returns NULL if the host doesn't let us.
+ */
+static unsigned char* _rb_map_twice(uint32_t size) {
+  int fd = memfd_create("ringbuf", 0);
+  if (fd < 0) {
+    return NULL;
+  }
+  unsigned char* buf = NULL;
+  if (ftruncate(fd, size) == 0) {
+    void* area = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (area != MAP_FAILED) {
+      if (mmap(area, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+               0) != MAP_FAILED &&
+          mmap((unsigned char*)area + size, size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) {
+        buf = area;
+      } else {
+        munmap(area, 2 * size);
+      }
+    }
+  }
+  close(fd);
+  return buf;
+}
+#endif
+
+ringbuf_t* rb_init_mirrored(const char* name, uint32_t size,
+                            uint32_t mirror_size, uint32_t caps) {
   ringbuf_t* r;
-  unsigned char* buf;
+  unsigned char* buf = NULL;
+  int mirror_mapped = 0;
 
-  if (size < 2 || !name) {
+  if (size < 2 || !name || mirror_size > size) {
     return NULL;
   }
 
   r = malloc(sizeof(ringbuf_t));
   assert(r);
-#if (CONFIG_SPIRAM_SUPPORT && \
-     (CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC))
-  buf = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-#else
-  buf = calloc(1, size);
+#if CONFIG_IDF_TARGET_LINUX
+  if (mirror_size > 0) {
+    long page = sysconf(_SC_PAGESIZE);
+    uint32_t mapped_size = (size + page - 1) / page * page;
+    buf = _rb_map_twice(mapped_size);
+    if (buf) {
+      size = mirror_size = mapped_size;
+      mirror_mapped = 1;
+    }
+  }
 #endif
+  if (!buf) {
+    buf = heap_caps_calloc(1, size + mirror_size, caps);
+  }
   assert(buf);
 
   r->name = (char*)name;
@@ -66,12 +124,25 @@ ringbuf_t* rb_init(const char* name, uint32_t size) {
   r->abort_write = 0;
   r->writer_finished = 0;
   r->reader_unblock = 0;
+  r->write_pos = 0;
+  r->read_pos = 0;
+  r->valid_pos = 0;
+  r->mirror_size = mirror_size;
+  r->mirror_mapped = mirror_mapped;
 
   return r;
 }
 
 void rb_cleanup(ringbuf_t* rb) {
+#if CONFIG_IDF_TARGET_LINUX
+  if (rb->mirror_mapped) {
+    munmap(rb->base, 2 * rb->size);
+  } else {
+    free(rb->base);
+  }
+#else
   free(rb->base);
+#endif
   rb->base = NULL;
   vSemaphoreDelete(rb->can_read);
   rb->can_read = NULL;
@@ -95,6 +166,25 @@ ssize_t rb_available(ringbuf_t* rb) {
   return (rb->size - rb->fill_cnt);
 }
 
+/**
+ * Copy whatever part of [dst, dst + len) lies in the first mirror_size bytes
+ * of the ring to the mirror past its end. Must be called with the lock held,
+ * right after writing to dst.
+ */
+static void _rb_update_mirror(ringbuf_t* rb, const uint8_t* dst, int len) {
+  if (rb->mirror_mapped) {
+    return;
+  }
+  int offset = dst - rb->base;
+  if (offset >= rb->mirror_size) {
+    return;
+  }
+  if (offset + len > rb->mirror_size) {
+    len = rb->mirror_size - offset;
+  }
+  memcpy(rb->base + rb->size + offset, dst, len);
+}
+
 int rb_read(ringbuf_t* rb, uint8_t* buf, int buf_len, uint32_t ticks_to_wait) {
   int read_size;
   int total_read_size = 0;
@@ -135,6 +225,7 @@ int rb_read(ringbuf_t* rb, uint8_t* buf, int buf_len, uint32_t ticks_to_wait) {
 
     buf_len -= read_size;
     rb->fill_cnt -= read_size;
+    rb->read_pos += read_size;
     total_read_size += read_size;
     if (buf) {
       buf += read_size;
@@ -207,14 +298,18 @@ int rb_write(ringbuf_t* rb, const uint8_t* buf, int buf_len,
       int wlen2 = write_size - wlen1;
       memcpy(rb->writeptr, buf, wlen1);
       memcpy(rb->base, buf + wlen1, wlen2);
+      _rb_update_mirror(rb, rb->writeptr, wlen1);
+      _rb_update_mirror(rb, rb->base, wlen2);
       rb->writeptr = rb->base + wlen2;
     } else {
       memcpy(rb->writeptr, buf, write_size);
+      _rb_update_mirror(rb, rb->writeptr, write_size);
       rb->writeptr = rb->writeptr + write_size;
     }
 
     buf_len -= write_size;
     rb->fill_cnt += write_size;
+    rb->write_pos += write_size;
     total_write_size += write_size;
     buf += write_size;
 
@@ -242,6 +337,179 @@ out:
   return total_write_size;
 }
 
+/**
+ * Discard the oldest len unread bytes. Must be called with the lock held.
+ */
+static void _rb_drop(ringbuf_t* rb, int len) {
+  rb->readptr += len;
+  if (rb->readptr >= rb->base + rb->size) {
+    rb->readptr -= rb->size;
+  }
+  rb->fill_cnt -= len;
+  rb->read_pos += len;
+}
+
+int rb_write_overwrite(ringbuf_t* rb, const uint8_t* buf, int buf_len) {
+  if (rb == NULL || buf == NULL || rb->abort_write == 1) {
+    return RB_FAIL;
+  }
+
+  /* Only the newest `size` bytes can ever be kept */
+  if (buf_len > rb->size) {
+    buf += buf_len - rb->size;
+    buf_len = rb->size;
+  }
+
+  xSemaphoreTake(rb->lock, portMAX_DELAY);
+  /* Drop the oldest unread bytes if the new ones don't fit */
+  int drop = buf_len - (rb->size - rb->fill_cnt);
+  if (drop > 0) {
+    _rb_drop(rb, drop);
+  }
+  if ((rb->writeptr + buf_len) > (rb->base + rb->size)) {
+    int wlen1 = rb->base + rb->size - rb->writeptr;
+    int wlen2 = buf_len - wlen1;
+    memcpy(rb->writeptr, buf, wlen1);
+    memcpy(rb->base, buf + wlen1, wlen2);
+    _rb_update_mirror(rb, rb->writeptr, wlen1);
+    _rb_update_mirror(rb, rb->base, wlen2);
+    rb->writeptr = rb->base + wlen2;
+  } else {
+    memcpy(rb->writeptr, buf, buf_len);
+    _rb_update_mirror(rb, rb->writeptr, buf_len);
+    rb->writeptr = rb->writeptr + buf_len;
+    if (rb->writeptr == rb->base + rb->size) {
+      rb->writeptr = rb->base;
+    }
+  }
+  rb->fill_cnt += buf_len;
+  rb->write_pos += buf_len;
+  xSemaphoreGive(rb->lock);
+
+  xSemaphoreGive(rb->can_read);
+  return buf_len;
+}
+
+int rb_skip_to_latest(ringbuf_t* rb, int keep_bytes) {
+  if (rb == NULL || keep_bytes < 0) {
+    return RB_FAIL;
+  }
+
+  xSemaphoreTake(rb->lock, portMAX_DELAY);
+  int skip = rb->fill_cnt - keep_bytes;
+  if (skip > 0) {
+    _rb_drop(rb, skip);
+  } else {
+    skip = 0;
+  }
+  xSemaphoreGive(rb->lock);
+
+  if (skip > 0) {
+    xSemaphoreGive(rb->can_write);
+  }
+  return skip;
+}
+
+/**
+ * Read a 64-bit position under the lock. The target is 32-bit, so a plain
+ * read can see half of a write made on the other core.
+ */
+static int64_t _rb_load_pos(ringbuf_t* rb, const int64_t* pos) {
+  xSemaphoreTake(rb->lock, portMAX_DELAY);
+  int64_t value = *pos;
+  xSemaphoreGive(rb->lock);
+  return value;
+}
+
+int64_t rb_write_pos(ringbuf_t* rb) { return _rb_load_pos(rb, &rb->write_pos); }
+
+int64_t rb_read_pos(ringbuf_t* rb) { return _rb_load_pos(rb, &rb->read_pos); }
+
+/**
+ * Find where the len bytes at absolute position pos are stored, or return
+ * RB_EVICTED/RB_NOT_AVAILABLE. Must be called with the lock held.
+ */
+static int _rb_locate(ringbuf_t* rb, int64_t pos, int len, uint8_t** src) {
+  int64_t oldest = rb->write_pos - rb->size;
+  if (oldest < rb->valid_pos) {
+    oldest = rb->valid_pos;
+  }
+  if (pos < oldest) {
+    return RB_EVICTED;
+  }
+  if (pos + len > rb->write_pos) {
+    return RB_NOT_AVAILABLE;
+  }
+  /* Walk back from the write pointer to find where pos is stored */
+  int back = rb->write_pos - pos;
+  *src = rb->writeptr - back;
+  if (*src < rb->base) {
+    *src += rb->size;
+  }
+  return len;
+}
+
+int rb_read_at(ringbuf_t* rb, int64_t pos, uint8_t* buf, int len) {
+  if (rb == NULL || buf == NULL || len < 0 || len > rb->size) {
+    return RB_FAIL;
+  }
+
+  xSemaphoreTake(rb->lock, portMAX_DELAY);
+  uint8_t* src;
+  int ret = _rb_locate(rb, pos, len, &src);
+  if (ret < 0) {
+    xSemaphoreGive(rb->lock);
+    return ret;
+  }
+  if ((src + len) > (rb->base + rb->size + rb->mirror_size)) {
+    int rlen1 = rb->base + rb->size - src;
+    memcpy(buf, src, rlen1);
+    memcpy(buf + rlen1, rb->base, len - rlen1);
+  } else {
+    memcpy(buf, src, len);
+  }
+  xSemaphoreGive(rb->lock);
+  return len;
+}
+
+int rb_peek_at(ringbuf_t* rb, int64_t pos, int len, int margin,
+               const uint8_t** ptr) {
+  if (rb == NULL || ptr == NULL || len < 0 || len > rb->mirror_size ||
+      margin < 0) {
+    return RB_FAIL;
+  }
+
+  xSemaphoreTake(rb->lock, portMAX_DELAY);
+  uint8_t* src;
+  int ret = _rb_locate(rb, pos, len, &src);
+  /* the next margin bytes written must not reach pos */
+  if (ret >= 0 && pos < rb->write_pos - rb->size + margin) {
+    ret = RB_EVICTED;
+  }
+  xSemaphoreGive(rb->lock);
+  if (ret < 0) {
+    return ret;
+  }
+  /* src + len can run past the end by at most mirror_size */
+  *ptr = src;
+  return len;
+}
+
+int rb_wait_for_pos(ringbuf_t* rb, int64_t pos, uint32_t ticks_to_wait) {
+  if (rb == NULL) {
+    return RB_FAIL;
+  }
+  while (_rb_load_pos(rb, &rb->write_pos) < pos) {
+    if (rb->abort_read == 1) {
+      return RB_ABORT;
+    }
+    if (xSemaphoreTake(rb->can_read, ticks_to_wait) != pdTRUE) {
+      return RB_NOT_AVAILABLE;
+    }
+  }
+  return 0;
+}
+
 /**
  * abort and set abort_read and abort_write to asked values.
  */
@@ -252,6 +520,7 @@ static void _rb_reset(ringbuf_t* rb, int abort_read, int abort_write) {
   xSemaphoreTake(rb->lock, portMAX_DELAY);
   rb->readptr = rb->writeptr = rb->base;
   rb->fill_cnt = 0;
+  rb->read_pos = rb->valid_pos = rb->write_pos;
   rb->writer_finished = 0;
   rb->reader_unblock = 0;
   rb->abort_read = abort_read;
@@ -28,6 +28,8 @@ extern "C" {
 #define RB_ABORT -1
 #define RB_WRITER_FINISHED -2
 #define RB_READER_UNBLOCK -3
+#define RB_EVICTED -4
+#define RB_NOT_AVAILABLE -5
 
 #if __has_include("esp_idf_version.h")
 #include "esp_idf_version.h"
@@ -56,9 +58,31 @@ typedef struct ringbuf {
   int abort_write;
   int writer_finished;  // to prevent infinite blocking for buffer read
   int reader_unblock;
+  int64_t write_pos;  /**< Absolute stream position of writeptr */
+  int64_t read_pos;   /**< Absolute stream position of readptr */
+  int64_t valid_pos;  /**< Oldest position still meaningful after a reset */
+  ssize_t mirror_size; /**< Bytes of base mirrored right after base + size */
+  int mirror_mapped;   /**< Mirror is a second mapping of base, not a copy */
 } ringbuf_t;
 
 ringbuf_t* rb_init(const char* rb_name, uint32_t size);
+/**
+ * @brief Same as rb_init, but the storage is allocated with the given
+ *        heap_caps flags, e.g. MALLOC_CAP_INTERNAL to keep it in SRAM or
+ *        MALLOC_CAP_SPIRAM to place it in external PSRAM.
+ */
+ringbuf_t* rb_init_caps(const char* rb_name, uint32_t size, uint32_t caps);
+/**
+ * @brief Create a ring whose first mirror_size bytes are repeated right after
+ *        its end, so that any window of up to mirror_size bytes can be
+ *        accessed through a single pointer with rb_peek_at, even when it
+ *        wraps around. Writes pay for keeping the mirror up to date.
+ *        On the linux target the storage is mapped twice back to back
+ *        instead, which mirrors the whole ring at no cost per write; size is
+ *        then rounded up to the page size.
+ */
+ringbuf_t* rb_init_mirrored(const char* rb_name, uint32_t size,
+                            uint32_t mirror_size, uint32_t caps);
 void rb_abort_read(ringbuf_t* rb);
 void rb_abort_write(ringbuf_t* rb);
 void rb_abort(ringbuf_t* rb);
@@ -74,6 +98,47 @@ ssize_t rb_available(ringbuf_t* rb);
 int rb_read(ringbuf_t* rb, uint8_t* buf, int len, uint32_t ticks_to_wait);
 int rb_write(ringbuf_t* rb, const uint8_t* buf, int len,
              uint32_t ticks_to_wait);
+/**
+ * @brief Write without ever blocking: if there isn't enough room, the oldest
+ *        unread bytes are dropped to make space for the new ones.
+ */
+int rb_write_overwrite(ringbuf_t* rb, const uint8_t* buf, int len);
+/**
+ * @brief Drop unread bytes so that at most keep_bytes of the newest data
+ *        remain to be read. Returns how many bytes were skipped.
+ */
+int rb_skip_to_latest(ringbuf_t* rb, int keep_bytes);
+/**
+ * @brief Absolute stream positions, counted in bytes since rb_init. They keep
+ *        increasing across wrap-arounds and resets.
+ */
+int64_t rb_write_pos(ringbuf_t* rb);
+int64_t rb_read_pos(ringbuf_t* rb);
+/**
+ * @brief Copy len bytes starting at absolute position pos without consuming
+ *        them. Any byte written during the last `size` bytes of the stream can
+ *        be fetched, whether it has been read already or not.
+ *        Returns len, RB_EVICTED if pos has already been overwritten or
+ *        RB_NOT_AVAILABLE if the range hasn't been written yet.
+ */
+int rb_read_at(ringbuf_t* rb, int64_t pos, uint8_t* buf, int len);
+/**
+ * @brief Like rb_read_at, but instead of copying, points *ptr at the len
+ *        bytes inside the ring. Only works on mirrored rings for len up to
+ *        mirror_size, and returns RB_FAIL otherwise. The bytes at pos are
+ *        overwritten once the writer has gone size bytes past pos, which is
+ *        sooner the older pos is, so this also returns RB_EVICTED unless at
+ *        least margin more bytes can be written before that happens. Pick a
+ *        margin covering what the writer can add while *ptr is in use, and
+ *        fall back to rb_read_at when it fails.
+ */
+int rb_peek_at(ringbuf_t* rb, int64_t pos, int len, int margin,
+               const uint8_t** ptr);
+/**
+ * @brief Block until the stream has been written up to position pos, waiting
+ *        at most ticks_to_wait for each write.
+ */
+int rb_wait_for_pos(ringbuf_t* rb, int64_t pos, uint32_t ticks_to_wait);
 void rb_cleanup(ringbuf_t* rb);
 void rb_signal_writer_finished(ringbuf_t* rb);
 void rb_wakeup_reader(ringbuf_t* rb);
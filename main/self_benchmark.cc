@@ -0,0 +1,325 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "self_benchmark.h"
+
+#include <cstring>
+
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+#include "micro_features_generator.h"
+#include "micro_model_settings.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "recognize_commands.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+extern const uint8_t yes_1000ms_start[] asm("_binary_yes_1000ms_wav_start");
+extern const uint8_t no_1000ms_start[] asm("_binary_no_1000ms_wav_start");
+extern const uint8_t noise_1000ms_start[] asm("_binary_noise_1000ms_wav_start");
+extern const uint8_t silence_1000ms_start[] asm(
+    "_binary_silence_1000ms_wav_start");
+extern const uint8_t yes_30ms_start[] asm("_binary_yes_30ms_wav_start");
+
+namespace {
+
+// Results from a streaming model aren't comparable with a whole window one.
+constexpr uint32_t kResultVersion = 1 + MICRO_SPEECH_STREAMING_MODEL;
+constexpr char kNvsNamespace[] = "self_bench";
+constexpr char kBaselineKey[] = "baseline";
+constexpr char kLatestKey[] = "latest";
+// A stage this much slower than the baseline is reported as degraded.
+constexpr int kDegradedPercent = 10;
+
+constexpr int kWavHeaderBytes = 44;
+// The recognizer only reports a label once it has this many results in
+// its averaging window.
+constexpr int kRecognizerResults = 3;
+constexpr int32_t kRecognizerStepMs = 250;
+
+// Each clip and the label the model should give it.
+struct SelfBenchmarkClipSource {
+  const char* name;
+  const uint8_t* wav;
+  const char* label;
+};
+const SelfBenchmarkClipSource kClips[kSelfBenchmarkClipCount] = {
+    {"yes", yes_1000ms_start, "yes"},
+    {"no", no_1000ms_start, "no"},
+    {"noise", noise_1000ms_start, "silence"},
+    {"silence", silence_1000ms_start, "silence"},
+};
+
+#if MICRO_SPEECH_STREAMING_MODEL
+// A streaming model's input only holds one slice, so the clip's window is
+// computed here first.
+int8_t g_window[kFeatureElementCount];
+#endif
+
+// Runs the model on the window in features. A streaming model is reset and
+// given the slices one at a time, and the scores of the last one are the
+// window's.
+TfLiteStatus InvokeOnWindow(tflite::MicroInterpreter* interpreter,
+                            const int8_t* features) {
+#if MICRO_SPEECH_STREAMING_MODEL
+  if (interpreter->Reset() != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  int8_t* input = tflite::GetTensorData<int8_t>(interpreter->input(0));
+  for (int slice = 0; slice < kFeatureCount; ++slice) {
+    memcpy(input, features + slice * kFeatureSize, kFeatureSize);
+    if (interpreter->Invoke() != kTfLiteOk) {
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+#else
+  (void)features;
+  return interpreter->Invoke();
+#endif
+}
+
+int LabelIndex(const char* label) {
+  for (int i = 0; i < kCategoryCount; ++i) {
+    if (label != nullptr && strcmp(label, kCategoryLabels[i]) == 0) {
+      return i;
+    }
+  }
+  return kCategoryCount;
+}
+
+// Percentage by which cycles is above baseline, or below it if negative.
+int PercentChange(uint32_t cycles, uint32_t baseline) {
+  if (baseline == 0) {
+    return 0;
+  }
+  return static_cast<int>(
+      (static_cast<int64_t>(cycles) - baseline) * 100 / baseline);
+}
+
+bool InitializeNvs() {
+  static bool initialized = false;
+  if (initialized) {
+    return true;
+  }
+  esp_err_t err = nvs_flash_init();
+  if (err == ESP_ERR_NVS_NO_FREE_PAGES ||
+      err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    if (nvs_flash_erase() != ESP_OK) {
+      return false;
+    }
+    err = nvs_flash_init();
+  }
+  initialized = (err == ESP_OK);
+  return initialized;
+}
+
+// Reads the baseline into baseline, returning false if there's none from
+// this version of the result, and stores result as the latest, and as the
+// baseline too if there wasn't one. Counts the run in result->run_count.
+bool StoreResult(SelfBenchmarkResult* result, SelfBenchmarkResult* baseline) {
+  nvs_handle_t handle;
+  if (!InitializeNvs() ||
+      nvs_open(kNvsNamespace, NVS_READWRITE, &handle) != ESP_OK) {
+    MicroPrintf("Self-benchmark: NVS is not available");
+    return false;
+  }
+  SelfBenchmarkResult latest;
+  size_t size = sizeof(latest);
+  if (nvs_get_blob(handle, kLatestKey, &latest, &size) == ESP_OK &&
+      size == sizeof(latest) && latest.version == kResultVersion) {
+    result->run_count = latest.run_count + 1;
+  } else {
+    result->run_count = 1;
+  }
+  size = sizeof(*baseline);
+  const bool have_baseline =
+      nvs_get_blob(handle, kBaselineKey, baseline, &size) == ESP_OK &&
+      size == sizeof(*baseline) && baseline->version == kResultVersion;
+  if (!have_baseline) {
+    nvs_set_blob(handle, kBaselineKey, result, sizeof(*result));
+  }
+  nvs_set_blob(handle, kLatestKey, result, sizeof(*result));
+  if (nvs_commit(handle) != ESP_OK) {
+    MicroPrintf("Self-benchmark: couldn't store the results");
+  }
+  nvs_close(handle);
+  return have_baseline;
+}
+
+void LogStage(const char* clip, const char* stage, uint32_t cycles,
+              uint32_t baseline, bool have_baseline, bool* degraded) {
+  if (!have_baseline) {
+    MicroPrintf("  %-8s %-10s %8u", clip, stage,
+                static_cast<unsigned>(cycles));
+    return;
+  }
+  const int change = PercentChange(cycles, baseline);
+  if (change > kDegradedPercent) {
+    *degraded = true;
+  }
+  MicroPrintf("  %-8s %-10s %8u  baseline %8u  %+d%%%s", clip, stage,
+              static_cast<unsigned>(cycles), static_cast<unsigned>(baseline),
+              change, (change > kDegradedPercent) ? "  DEGRADED" : "");
+}
+
+}  // namespace
+
+TfLiteStatus RunSelfBenchmark(tflite::MicroInterpreter* interpreter) {
+  TfLiteTensor* input = interpreter->input(0);
+  if (input->bytes != kModelInputElementCount) {
+    MicroPrintf("Self-benchmark: the model input isn't %d features",
+                kModelInputElementCount);
+    return kTfLiteError;
+  }
+#if MICRO_SPEECH_STREAMING_MODEL
+  int8_t* features = g_window;
+#else
+  int8_t* features = tflite::GetTensorData<int8_t>(input);
+#endif
+
+  SelfBenchmarkResult result;
+  memset(&result, 0, sizeof(result));
+  result.version = kResultVersion;
+  bool all_passed = true;
+
+  // One window from scratch, the cost of a slice when nothing can be
+  // carried over from the previous one.
+  if (InitializeMicroFeatures() != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  uint32_t start = esp_cpu_get_cycle_count();
+  if (GenerateFeatureSlices(
+          reinterpret_cast<const int16_t*>(yes_30ms_start + kWavHeaderBytes),
+          1, features) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  result.window_cycles = esp_cpu_get_cycle_count() - start;
+
+  for (int c = 0; c < kSelfBenchmarkClipCount; ++c) {
+    SelfBenchmarkClip& clip = result.clips[c];
+    const int16_t* samples =
+        reinterpret_cast<const int16_t*>(kClips[c].wav + kWavHeaderBytes);
+
+    // Each clip is one whole window, computed the way the feature
+    // provider's first window is.
+    if (InitializeMicroFeatures() != kTfLiteOk) {
+      return kTfLiteError;
+    }
+    start = esp_cpu_get_cycle_count();
+    if (GenerateFeatureSlices(samples, kFeatureCount, features) !=
+        kTfLiteOk) {
+      MicroPrintf("Self-benchmark: feature generation failed");
+      return kTfLiteError;
+    }
+    clip.frontend_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    if (InvokeOnWindow(interpreter, features) != kTfLiteOk) {
+      MicroPrintf("Self-benchmark: Invoke failed");
+      return kTfLiteError;
+    }
+    clip.invoke_cycles = esp_cpu_get_cycle_count() - start;
+
+    // A recognizer of its own, fed the same scores until it has enough to
+    // average. The last call is the one timed.
+    RecognizeCommands recognizer;
+    const char* found_command = nullptr;
+    float score = 0;
+    bool is_new_command = false;
+    for (int i = 0; i < kRecognizerResults; ++i) {
+      start = esp_cpu_get_cycle_count();
+      if (recognizer.ProcessLatestResults(
+              interpreter->output(0), i * kRecognizerStepMs, false,
+              &found_command, &score, &is_new_command) != kTfLiteOk) {
+        return kTfLiteError;
+      }
+      clip.recognize_cycles = esp_cpu_get_cycle_count() - start;
+    }
+    clip.label_index = LabelIndex(found_command);
+    clip.passed = (clip.label_index == LabelIndex(kClips[c].label));
+    if (!clip.passed) {
+      all_passed = false;
+      MicroPrintf("Self-benchmark: \"%s\" was recognized as \"%s\"",
+                  kClips[c].name, found_command ? found_command : "nothing");
+    }
+  }
+
+  SelfBenchmarkResult baseline = {};
+  const bool have_baseline = StoreResult(&result, &baseline);
+  bool degraded = false;
+  MicroPrintf("Self-benchmark run %u, cycles%s:",
+              static_cast<unsigned>(result.run_count),
+              have_baseline ? " against this unit's first run" : "");
+  LogStage("30 ms", "window", result.window_cycles, baseline.window_cycles,
+           have_baseline, &degraded);
+  for (int c = 0; c < kSelfBenchmarkClipCount; ++c) {
+    const SelfBenchmarkClip& clip = result.clips[c];
+    const SelfBenchmarkClip& base = baseline.clips[c];
+    LogStage(kClips[c].name, "frontend", clip.frontend_cycles,
+             base.frontend_cycles, have_baseline, &degraded);
+    LogStage(kClips[c].name, "invoke", clip.invoke_cycles, base.invoke_cycles,
+             have_baseline, &degraded);
+    LogStage(kClips[c].name, "recognize", clip.recognize_cycles,
+             base.recognize_cycles, have_baseline, &degraded);
+  }
+  // What running the model on one more slice costs, the whole window for a
+  // window model and just that slice for a streaming one.
+  uint32_t invoke_cycles = 0;
+  for (int c = 0; c < kSelfBenchmarkClipCount; ++c) {
+    invoke_cycles += result.clips[c].invoke_cycles / kSelfBenchmarkClipCount;
+  }
+  MicroPrintf("  Invoke per slice: %u cycles",
+              static_cast<unsigned>(MICRO_SPEECH_STREAMING_MODEL
+                                        ? invoke_cycles / kFeatureCount
+                                        : invoke_cycles));
+#if MICRO_SPEECH_STREAMING_MODEL
+  // The state is that of the last clip, not of the audio to come.
+  interpreter->Reset();
+#endif
+  if (degraded) {
+    MicroPrintf("Self-benchmark: slower than the baseline by more than %d%%",
+                kDegradedPercent);
+  }
+  MicroPrintf("Self-benchmark %s", all_passed ? "passed" : "FAILED");
+  return all_passed ? kTfLiteOk : kTfLiteError;
+}
+
+bool SelfBenchmarkRequested() {
+#if MICRO_SPEECH_SELF_BENCHMARK_GPIO >= 0
+  constexpr gpio_num_t kButton =
+      static_cast<gpio_num_t>(MICRO_SPEECH_SELF_BENCHMARK_GPIO);
+  static bool configured = false;
+  static bool was_pressed = false;
+  if (!configured) {
+    gpio_config_t config = {};
+    config.pin_bit_mask = 1ULL << MICRO_SPEECH_SELF_BENCHMARK_GPIO;
+    config.mode = GPIO_MODE_INPUT;
+    config.pull_up_en = GPIO_PULLUP_ENABLE;
+    config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    config.intr_type = GPIO_INTR_DISABLE;
+    configured = (gpio_config(&config) == ESP_OK);
+    if (!configured) {
+      return false;
+    }
+  }
+  const bool pressed = (gpio_get_level(kButton) == 0);
+  const bool requested = pressed && !was_pressed;
+  was_pressed = pressed;
+  return requested;
+#else
+  return false;
+#endif
+}
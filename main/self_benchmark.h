@@ -0,0 +1,73 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_SELF_BENCHMARK_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_SELF_BENCHMARK_H_
+
+// Set to 1 to run the self-benchmark at the end of setup(). It takes the
+// model and the frontend away from the microphone for a while, so it is off
+// by default like the benchmarks of benchmarks.h, but unlike them it is
+// meant for builds that go into the field: it checks that the embedded test
+// clips are still recognized and keeps the unit's timings in NVS, so a unit
+// that has become slower stands out.
+#ifndef MICRO_SPEECH_SELF_BENCHMARK
+#define MICRO_SPEECH_SELF_BENCHMARK 0
+#endif
+
+// GPIO of a button that runs the self-benchmark again when pressed, active
+// low. GPIO0 is the BOOT button of ESP32-S3 boards. Set to -1 for none.
+#ifndef MICRO_SPEECH_SELF_BENCHMARK_GPIO
+#define MICRO_SPEECH_SELF_BENCHMARK_GPIO 0
+#endif
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+// The embedded one second clips, in the order of SelfBenchmarkResult::clips.
+constexpr int kSelfBenchmarkClipCount = 4;
+
+// Cycles of each stage for one clip, and whether the recognizer gave the
+// clip's label.
+struct SelfBenchmarkClip {
+  uint32_t frontend_cycles;
+  uint32_t invoke_cycles;
+  uint32_t recognize_cycles;
+  uint8_t label_index;
+  uint8_t passed;
+};
+
+// What is kept in NVS: the first run as the unit's baseline, and the latest.
+struct SelfBenchmarkResult {
+  uint32_t version;
+  SelfBenchmarkClip clips[kSelfBenchmarkClipCount];
+  // One 30 ms window through the frontend from scratch.
+  uint32_t window_cycles;
+  uint32_t run_count;
+};
+
+// Runs every embedded clip through the frontend, the model and a recognizer
+// of its own, logs the results against the stored baseline and stores them.
+// The model's input tensor and the generator's own frontend state are
+// overwritten, and a streaming model's state is reset, so a FeatureProvider
+// has to be restarted afterwards. Returns an error if a stage fails or a clip isn't recognized.
+TfLiteStatus RunSelfBenchmark(tflite::MicroInterpreter* interpreter);
+
+// Returns true once for every press of the MICRO_SPEECH_SELF_BENCHMARK_GPIO
+// button. Cheap enough to call on every loop().
+bool SelfBenchmarkRequested();
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_SELF_BENCHMARK_H_
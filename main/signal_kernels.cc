@@ -0,0 +1,354 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "signal_kernels.h"
+
+#include <cstring>
+
+#include "flatbuffers/flexbuffers.h"
+#include "frontend_stages.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_utils.h"
+
+namespace {
+
+// The RFFT is only built for the FFT length the frontend uses.
+constexpr int kFftLength = DefaultFrontendGeometry::kFftLength;
+constexpr int kFftBins = DefaultFrontendGeometry::kFftBins;
+
+const flexbuffers::Map Options(const char* buffer, size_t length) {
+  return flexbuffers::GetRoot(reinterpret_cast<const uint8_t*>(buffer), length)
+      .AsMap();
+}
+
+template <typename Params>
+Params* AllocateParams(TfLiteContext* context) {
+  return static_cast<Params*>(
+      context->AllocatePersistentBuffer(context, sizeof(Params)));
+}
+
+// Length of the innermost dimension of a tensor.
+int InnerSize(const TfLiteEvalTensor* tensor) {
+  return tensor->dims->data[tensor->dims->size - 1];
+}
+
+// SignalWindow
+
+struct WindowParams {
+  int shift;
+};
+
+void* WindowInit(TfLiteContext* context, const char* buffer, size_t length) {
+  WindowParams* params = AllocateParams<WindowParams>(context);
+  if (params != nullptr) {
+    params->shift = Options(buffer, length)["shift"].AsInt32();
+  }
+  return params;
+}
+
+TfLiteStatus WindowPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, tflite::NumInputs(node), 2);
+  TF_LITE_ENSURE_EQ(context, tflite::NumOutputs(node), 1);
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  TfLiteTensor* input = micro_context->AllocateTempInputTensor(node, 0);
+  TfLiteTensor* weights = micro_context->AllocateTempInputTensor(node, 1);
+  TF_LITE_ENSURE(context, input != nullptr && weights != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt16);
+  TF_LITE_ENSURE_TYPES_EQ(context, weights->type, kTfLiteInt16);
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(weights);
+  return kTfLiteOk;
+}
+
+TfLiteStatus WindowInvoke(TfLiteContext* context, TfLiteNode* node) {
+  const auto* params = static_cast<const WindowParams*>(node->user_data);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  const TfLiteEvalTensor* weights =
+      tflite::micro::GetEvalInput(context, node, 1);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  const int16_t* input_data = tflite::micro::GetTensorData<int16_t>(input);
+  int16_t* output_data = tflite::micro::GetTensorData<int16_t>(output);
+  const int size = InnerSize(input);
+  const int count = tflite::ElementCount(*input->dims);
+  for (int i = 0; i < count; i += size) {
+    FrontendApplyWindow(input_data + i,
+                        tflite::micro::GetTensorData<int16_t>(weights), size,
+                        params->shift, output_data + i);
+  }
+  return kTfLiteOk;
+}
+
+// SignalRfft
+
+struct RfftParams {
+  int input_size;
+  int16_t* padded_input;
+  FrontendComplex* scratch;
+};
+
+void* RfftInit(TfLiteContext* context, const char* buffer, size_t length) {
+  RfftParams* params = AllocateParams<RfftParams>(context);
+  if (params == nullptr) {
+    return nullptr;
+  }
+  if (Options(buffer, length)["fft_length"].AsInt32() != kFftLength) {
+    MicroPrintf("Fast SignalRfft only supports an fft_length of %d",
+                kFftLength);
+    return nullptr;
+  }
+  params->padded_input = static_cast<int16_t*>(context->AllocatePersistentBuffer(
+      context, kFftLength * sizeof(int16_t)));
+  params->scratch =
+      static_cast<FrontendComplex*>(context->AllocatePersistentBuffer(
+          context, kFftLength / 2 * sizeof(FrontendComplex)));
+  if (params->padded_input == nullptr || params->scratch == nullptr) {
+    return nullptr;
+  }
+  return params;
+}
+
+TfLiteStatus RfftPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE(context, node->user_data != nullptr);
+  TF_LITE_ENSURE_EQ(context, tflite::NumInputs(node), 1);
+  TF_LITE_ENSURE_EQ(context, tflite::NumOutputs(node), 1);
+  auto* params = static_cast<RfftParams*>(node->user_data);
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  TfLiteTensor* input = micro_context->AllocateTempInputTensor(node, 0);
+  TfLiteTensor* output = micro_context->AllocateTempOutputTensor(node, 0);
+  TF_LITE_ENSURE(context, input != nullptr && output != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt16);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt16);
+  params->input_size = input->dims->data[input->dims->size - 1];
+  TF_LITE_ENSURE(context, params->input_size <= kFftLength);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[output->dims->size - 1],
+                    kFftBins * 2);
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  return kTfLiteOk;
+}
+
+TfLiteStatus RfftInvoke(TfLiteContext* context, TfLiteNode* node) {
+  const auto* params = static_cast<const RfftParams*>(node->user_data);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  const int16_t* input_data = tflite::micro::GetTensorData<int16_t>(input);
+  auto* output_data = reinterpret_cast<FrontendComplex*>(
+      tflite::micro::GetTensorData<int16_t>(output));
+  const int count = tflite::ElementCount(*input->dims);
+  for (int i = 0; i < count; i += params->input_size) {
+    memcpy(params->padded_input, input_data + i,
+           params->input_size * sizeof(int16_t));
+    memset(params->padded_input + params->input_size, 0,
+           (kFftLength - params->input_size) * sizeof(int16_t));
+    FrontendRfft<kFftLength>(params->padded_input, params->scratch,
+                             output_data);
+    output_data += kFftBins;
+  }
+  return kTfLiteOk;
+}
+
+// SignalEnergy
+
+struct EnergyParams {
+  int start_index;
+  int end_index;
+};
+
+void* EnergyInit(TfLiteContext* context, const char* buffer, size_t length) {
+  EnergyParams* params = AllocateParams<EnergyParams>(context);
+  if (params != nullptr) {
+    const flexbuffers::Map options = Options(buffer, length);
+    params->start_index = options["start_index"].AsInt32();
+    params->end_index = options["end_index"].AsInt32();
+  }
+  return params;
+}
+
+TfLiteStatus EnergyPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, tflite::NumInputs(node), 1);
+  TF_LITE_ENSURE_EQ(context, tflite::NumOutputs(node), 1);
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  TfLiteTensor* input = micro_context->AllocateTempInputTensor(node, 0);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt16);
+  micro_context->DeallocateTempTfLiteTensor(input);
+  return kTfLiteOk;
+}
+
+TfLiteStatus EnergyInvoke(TfLiteContext* context, TfLiteNode* node) {
+  const auto* params = static_cast<const EnergyParams*>(node->user_data);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  FrontendSpectrumToEnergy(reinterpret_cast<const FrontendComplex*>(
+                               tflite::micro::GetTensorData<int16_t>(input)),
+                           params->start_index, params->end_index,
+                           tflite::micro::GetTensorData<uint32_t>(output));
+  return kTfLiteOk;
+}
+
+// SignalFilterBank
+
+struct FilterBankParams {
+  FrontendFilterbank filterbank;
+  uint64_t* work_area;
+};
+
+void* FilterBankInit(TfLiteContext* context, const char* buffer,
+                     size_t length) {
+  FilterBankParams* params = AllocateParams<FilterBankParams>(context);
+  if (params == nullptr) {
+    return nullptr;
+  }
+  const int num_channels = Options(buffer, length)["num_channels"].AsInt32();
+  params->filterbank.num_channels = num_channels;
+  params->work_area = static_cast<uint64_t*>(context->AllocatePersistentBuffer(
+      context, (num_channels + 1) * sizeof(uint64_t)));
+  if (params->work_area == nullptr) {
+    return nullptr;
+  }
+  return params;
+}
+
+TfLiteStatus FilterBankPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE(context, node->user_data != nullptr);
+  TF_LITE_ENSURE_EQ(context, tflite::NumInputs(node), 6);
+  TF_LITE_ENSURE_EQ(context, tflite::NumOutputs(node), 1);
+  auto* params = static_cast<FilterBankParams*>(node->user_data);
+  const int channel_count = params->filterbank.num_channels + 1;
+
+  // The tables are constant, so the trimmed copies can be built once here.
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  TfLiteTensor* tables[5];
+  for (int i = 0; i < 5; ++i) {
+    tables[i] = micro_context->AllocateTempInputTensor(node, i + 1);
+    TF_LITE_ENSURE(context, tables[i] != nullptr);
+    TF_LITE_ENSURE_TYPES_EQ(context, tables[i]->type, kTfLiteInt16);
+  }
+  for (int i = 2; i < 5; ++i) {
+    TF_LITE_ENSURE_EQ(context, tables[i]->dims->data[0], channel_count);
+  }
+  const FrontendFilterbank padded = {
+      params->filterbank.num_channels,
+      tables[0]->data.i16,
+      tables[1]->data.i16,
+      tables[2]->data.i16,
+      tables[3]->data.i16,
+      tables[4]->data.i16,
+  };
+  int16_t* trimmed = static_cast<int16_t*>(context->AllocatePersistentBuffer(
+      context, 3 * channel_count * sizeof(int16_t)));
+  TF_LITE_ENSURE(context, trimmed != nullptr);
+  FrontendTrimFilterbank(padded, trimmed, trimmed + channel_count,
+                         trimmed + 2 * channel_count);
+  params->filterbank.weights = padded.weights;
+  params->filterbank.unweights = padded.unweights;
+  params->filterbank.channel_frequency_starts = trimmed;
+  params->filterbank.channel_weight_starts = trimmed + channel_count;
+  params->filterbank.channel_widths = trimmed + 2 * channel_count;
+  for (int i = 0; i < 5; ++i) {
+    micro_context->DeallocateTempTfLiteTensor(tables[i]);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus FilterBankInvoke(TfLiteContext* context, TfLiteNode* node) {
+  const auto* params = static_cast<const FilterBankParams*>(node->user_data);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  FrontendFilterbankAccumulate(params->filterbank,
+                               tflite::micro::GetTensorData<uint32_t>(input),
+                               params->work_area);
+  // The first channel only collects the leading unweights.
+  memcpy(tflite::micro::GetTensorData<uint64_t>(output),
+         params->work_area + 1,
+         params->filterbank.num_channels * sizeof(uint64_t));
+  return kTfLiteOk;
+}
+
+// SignalFilterBankLog
+
+struct FilterBankLogParams {
+  int input_correction_bits;
+  int output_scale;
+};
+
+void* FilterBankLogInit(TfLiteContext* context, const char* buffer,
+                        size_t length) {
+  FilterBankLogParams* params = AllocateParams<FilterBankLogParams>(context);
+  if (params != nullptr) {
+    const flexbuffers::Map options = Options(buffer, length);
+    params->input_correction_bits =
+        options["input_correction_bits"].AsInt32();
+    params->output_scale = options["output_scale"].AsInt32();
+  }
+  return params;
+}
+
+TfLiteStatus FilterBankLogPrepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_EQ(context, tflite::NumInputs(node), 1);
+  TF_LITE_ENSURE_EQ(context, tflite::NumOutputs(node), 1);
+  tflite::MicroContext* micro_context = tflite::GetMicroContext(context);
+  TfLiteTensor* output = micro_context->AllocateTempOutputTensor(node, 0);
+  TF_LITE_ENSURE(context, output != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt16);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  return kTfLiteOk;
+}
+
+TfLiteStatus FilterBankLogInvoke(TfLiteContext* context, TfLiteNode* node) {
+  const auto* params = static_cast<const FilterBankLogParams*>(node->user_data);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  FrontendFilterbankLog(tflite::micro::GetTensorData<uint32_t>(input),
+                        InnerSize(input), params->output_scale,
+                        params->input_correction_bits,
+                        tflite::micro::GetTensorData<int16_t>(output));
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TFLMRegistration* Register_FAST_WINDOW() {
+  static TFLMRegistration r =
+      tflite::micro::RegisterOp(WindowInit, WindowPrepare, WindowInvoke);
+  return &r;
+}
+
+TFLMRegistration* Register_FAST_RFFT() {
+  static TFLMRegistration r =
+      tflite::micro::RegisterOp(RfftInit, RfftPrepare, RfftInvoke);
+  return &r;
+}
+
+TFLMRegistration* Register_FAST_ENERGY() {
+  static TFLMRegistration r =
+      tflite::micro::RegisterOp(EnergyInit, EnergyPrepare, EnergyInvoke);
+  return &r;
+}
+
+TFLMRegistration* Register_FAST_FILTER_BANK() {
+  static TFLMRegistration r = tflite::micro::RegisterOp(
+      FilterBankInit, FilterBankPrepare, FilterBankInvoke);
+  return &r;
+}
+
+TFLMRegistration* Register_FAST_FILTER_BANK_LOG() {
+  static TFLMRegistration r = tflite::micro::RegisterOp(
+      FilterBankLogInit, FilterBankLogPrepare, FilterBankLogInvoke);
+  return &r;
+}
@@ -0,0 +1,39 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_SIGNAL_KERNELS_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_SIGNAL_KERNELS_H_
+
+#include "tensorflow/lite/micro/micro_common.h"
+
+// Replacements for some of the signal library kernels, built on the stages of
+// the native audio frontend, to be registered with AddCustom under the
+// original op names. They produce exactly the same outputs as the stock
+// kernels, so g_audio_preprocessor_int8_tflite runs unchanged:
+//  - SignalRfft precomputes the twiddles of each FFT stage in the order
+//    they're used and runs the stages in a loop instead of recursing.
+//  - SignalFilterBank trims the zero weights that pad out every channel
+//    once, in Prepare, rather than multiplying by them on every invoke.
+//  - SignalWindow, SignalEnergy and SignalFilterBankLog are the frontend's
+//    loops, which skip some of the stock kernels' per-call setup.
+// The RFFT only supports int16 input and the fft_length of
+// DefaultFrontendGeometry.
+TFLMRegistration* Register_FAST_WINDOW();
+TFLMRegistration* Register_FAST_RFFT();
+TFLMRegistration* Register_FAST_ENERGY();
+TFLMRegistration* Register_FAST_FILTER_BANK();
+TFLMRegistration* Register_FAST_FILTER_BANK_LOG();
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_SIGNAL_KERNELS_H_
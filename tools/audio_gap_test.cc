@@ -0,0 +1,217 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host check of the gap handling that AUDIO_GAP_FAULT_INJECTION_PERIOD
+// exercises on the device. audio_provider.cc's capture task runs on a thread
+// over the real ring buffers, reading 100ms blocks from host_microphone.h
+// and dropping every AUDIO_GAP_FAULT_INJECTION_PERIOD-th of them itself.
+// After each block, FeatureProvider fetches its new slices through
+// GetAudioSamples and AudioRangeHasGap as on the device, and the test checks
+// that exactly the slices spliced across a drop are flagged, and that
+// RecognizeCommands doesn't report a command from a window holding one of
+// them even though the scores are confident. tools/CMakeLists.txt builds
+// and registers it when TFLITE_MICRO_DIR is set:
+//
+//   cmake -S tools -B build -DTFLITE_MICRO_DIR=<tflite-micro>
+//   cmake --build build && ctest --test-dir build
+//
+// It prints each failure and exits with 1 if there were any.
+
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "audio_gap_log.h"
+#include "audio_provider.h"
+#include "feature_provider.h"
+#include "host_microphone.h"
+#include "micro_model_settings.h"
+#include "recognize_commands.h"
+
+namespace {
+
+// What CaptureSamples reads from I2S at a time.
+constexpr int kBlockSamples = kAudioSampleFrequency / 10;
+// Far enough apart for the averaging window to come clean between drops,
+// and enough of them to go round AudioGapLog's markers more than once. The
+// stream carries on for a while after the last one.
+constexpr int kFaultPeriod = AUDIO_GAP_FAULT_INJECTION_PERIOD;
+static_assert(kFaultPeriod > 1, "The first block must get through");
+constexpr int kBlockCount =
+    kFaultPeriod * (AudioGapLog::kMaxMarkers + 4) + kFaultPeriod / 2;
+// The category the fake model is sure it hears.
+constexpr int kHeardCategory = 2;
+
+int g_failures = 0;
+
+void Fail(const char* what, int step) {
+  printf("FAIL at slice %d: %s\n", step, what);
+  ++g_failures;
+}
+
+// Something other than silence, so computed slices aren't all alike.
+std::vector<int16_t> MakeAudio(int sample_count) {
+  std::vector<int16_t> audio(sample_count);
+  uint32_t state = 12345;
+  for (int i = 0; i < sample_count; ++i) {
+    state = state * 1103515245 + 12345;
+    audio[i] = static_cast<int16_t>(static_cast<int>((state >> 16) & 0x7fff) -
+                                    0x4000) /
+               4;
+  }
+  return audio;
+}
+
+}  // namespace
+
+int main() {
+  const std::vector<int16_t> audio = MakeAudio(kBlockCount * kBlockSamples);
+  HostMicrophoneSetAudio(audio.data(), audio.size());
+
+  // The capture task is started by the first fetch, which then waits for
+  // its first block, so that fetch has to be made from another thread.
+  std::thread start_capture([] {
+    int16_t unused;
+    GetAudioSamplesAt(0, 0, &unused);
+  });
+  HostMicrophoneRelease(1);
+  start_capture.join();
+
+  // The model scores every window as kHeardCategory with certainty, so any
+  // window without a gap can fire, and none with one may.
+  int8_t scores[kCategoryCount];
+  for (int i = 0; i < kCategoryCount; ++i) {
+    scores[i] = (i == kHeardCategory) ? 127 : -128;
+  }
+  alignas(TfLiteIntArray) uint8_t dims_storage[sizeof(TfLiteIntArray) +
+                                               2 * sizeof(int)] = {};
+  TfLiteIntArray* dims = reinterpret_cast<TfLiteIntArray*>(dims_storage);
+  dims->size = 2;
+  dims->data[0] = 1;
+  dims->data[1] = kCategoryCount;
+  TfLiteTensor output = {};
+  output.type = kTfLiteInt8;
+  output.dims = dims;
+  output.data.int8 = scores;
+  output.params.scale = 1.0f / 256;
+  output.params.zero_point = -128;
+
+  static int8_t feature_data[FeatureProvider::kElementCount];
+  FeatureProvider feature_provider(feature_data);
+  RecognizeCommands recognizer;
+
+  // A dropped block adds no samples, only a marker where the blocks either
+  // side of it now meet, so the marker is at the samples captured so far.
+  std::vector<int64_t> gaps;
+  int64_t captured_samples = kBlockSamples;
+  std::set<int> flagged_steps;
+  int32_t previous_time = 0;
+  int clean_windows = 0;
+  int gap_windows = 0;
+  int fired = 0;
+  for (int block = 2; block <= kBlockCount; ++block) {
+    HostMicrophoneRelease(block);
+    if (block % kFaultPeriod == 0) {
+      gaps.push_back(captured_samples);
+    } else {
+      captured_samples += kBlockSamples;
+    }
+    const int32_t current_time = LatestAudioTimestamp();
+    if (current_time != captured_samples / (kAudioSampleFrequency / 1000)) {
+      Fail("timestamp doesn't match the audio captured", block);
+    }
+    int how_many_new_slices = 0;
+    if (feature_provider.PopulateFeatureData(previous_time, current_time,
+                                             &how_many_new_slices) !=
+        kTfLiteOk) {
+      Fail("PopulateFeatureData failed", block);
+      continue;
+    }
+    previous_time = current_time;
+
+    // Every slice of the window whose audio holds a marker in its interior,
+    // and no other, is flagged. The markers fall on block boundaries,
+    // which are stride boundaries too, so each drop splits one window.
+    const int current_step = current_time / kFeatureStrideMs;
+    for (int slice = 0; slice < kFeatureCount; ++slice) {
+      const int step = current_step - kFeatureCount + 1 + slice;
+      const int64_t start =
+          static_cast<int64_t>(step) * kAudioSampleStrideCount -
+          kAudioSampleDurationCount;
+      bool expected = false;
+      for (int64_t gap : gaps) {
+        if (gap > start && gap < start + kAudioSampleDurationCount) {
+          expected = true;
+        }
+      }
+      const bool flagged = feature_provider.SliceHasGap(slice);
+      if (flagged != expected) {
+        Fail(flagged ? "flagged without a drop in it"
+                     : "not flagged across a drop",
+             step);
+      }
+      if (flagged) {
+        flagged_steps.insert(step);
+      }
+    }
+
+    const bool window_has_gap = feature_provider.WindowHasGap();
+    const char* found_command = nullptr;
+    float score = 0;
+    bool is_new_command = false;
+    if (recognizer.ProcessLatestResults(&output, current_time, window_has_gap,
+                                        &found_command, &score,
+                                        &is_new_command) != kTfLiteOk) {
+      Fail("ProcessLatestResults failed", current_step);
+      continue;
+    }
+    if (window_has_gap) {
+      ++gap_windows;
+      if (is_new_command) {
+        Fail("fired on a window with a gap", current_step);
+      }
+    } else {
+      ++clean_windows;
+    }
+    if (is_new_command) {
+      ++fired;
+    }
+  }
+  if (flagged_steps.size() != gaps.size()) {
+    printf("FAIL: %d slices flagged for %d drops\n",
+           static_cast<int>(flagged_steps.size()),
+           static_cast<int>(gaps.size()));
+    ++g_failures;
+  }
+  if (gap_windows == 0 || clean_windows == 0 || fired == 0) {
+    printf("FAIL: %d windows with gaps, %d without, %d commands\n",
+           gap_windows, clean_windows, fired);
+    ++g_failures;
+  }
+
+  printf("%d drops, %d slices flagged, %d of %d windows with gaps, "
+         "%d commands\n",
+         static_cast<int>(gaps.size()),
+         static_cast<int>(flagged_steps.size()), gap_windows,
+         gap_windows + clean_windows, fired);
+  if (g_failures > 0) {
+    printf("%d failures\n", g_failures);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
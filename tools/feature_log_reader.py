@@ -0,0 +1,263 @@
+# Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Converts a feature log into training tensors.
+
+The log is what MICRO_SPEECH_FEATURE_LOG records on the device, in the
+format described in main/feature_log_format.h. Read it off the device with
+
+  esptool.py read_flash 0x150000 0xb0000 featlog.bin
+
+using the offset and size of the featlog partition in partitions.csv, or
+write one on the host with tools/frontend_features.cc --log.
+
+Writes these .npy files to the output directory:
+
+  rows.npy           int8 [rows, feature_size], every logged row in order
+  row_times.npy      int32 [rows], the time in ms each row's window ends
+  row_gaps.npy       uint8 [rows], 1 for rows blanked or filled in
+  scores.npy         int8 [inferences, categories], the model's scores
+  score_times.npy    int32 [inferences]
+  windows.npy        int8 [windows, window_slices, feature_size], runs of
+                     consecutive rows without gaps, as the model sees them
+  window_times.npy   int32 [windows], the time each window ends
+  window_scores.npy  int8 [windows, categories], the scores of the first
+                     inference after each window's last row was computed,
+                     which normally ran on that window or one a few rows on
+
+Only the standard library is needed. np.load reads the files.
+
+Example:
+
+  python3 tools/feature_log_reader.py featlog.bin dataset/ \\
+      --window-slices 49 --window-step 10
+"""
+
+import argparse
+import array
+import os
+import struct
+import sys
+
+BLOCK_SIZE = 4096
+MAGIC = 0x4c53574b
+VERSION = 1
+HEADER = struct.Struct('<IHHIBBBB')
+ROW = 1
+SCORES = 2
+ROW_GAP = 0x80
+TYPE_MASK = 0x7f
+
+
+def UnpackBits(data, size):
+  """Undoes FeatureLogPackBits, returning size bytes."""
+  output = bytearray()
+  i = 0
+  while i < len(data):
+    control = data[i]
+    i += 1
+    if control < 128:
+      output += data[i:i + control + 1]
+      i += control + 1
+    elif control > 128:
+      output += bytes([data[i]]) * (257 - control)
+      i += 1
+  if len(output) != size:
+    raise ValueError('row decodes to %d bytes, not %d' % (len(output), size))
+  return output
+
+
+def ReadVarint(data, i):
+  """Returns the varint at data[i] and the index after it."""
+  value = 0
+  shift = 0
+  while True:
+    byte = data[i]
+    i += 1
+    value |= (byte & 0x7f) << shift
+    shift += 7
+    if byte < 0x80:
+      return value, i
+
+
+def ReadTime(data, i, previous_ms):
+  """Returns the record time at data[i] and the index after it."""
+  zigzag, i = ReadVarint(data, i)
+  delta = (zigzag >> 1) ^ -(zigzag & 1)
+  return previous_ms + delta, i
+
+
+def Signed(values):
+  return array.array('b', bytes(values))
+
+
+def ReadBlocks(data):
+  """Returns the header and records of each block of the log, in order."""
+  blocks = []
+  for offset in range(0, len(data) - BLOCK_SIZE + 1, BLOCK_SIZE):
+    (magic, version, used, sequence, feature_size, score_count, stride_ms,
+     _) = HEADER.unpack_from(data, offset)
+    if magic != MAGIC or version != VERSION:
+      break
+    header = {'sequence': sequence, 'feature_size': feature_size,
+              'score_count': score_count, 'stride_ms': stride_ms}
+    blocks.append((header, data[offset + HEADER.size:offset + used]))
+  blocks.sort(key=lambda block: block[0]['sequence'])
+  return blocks
+
+
+def ReadLog(path):
+  with open(path, 'rb') as f:
+    data = f.read()
+  # The position of each record in the whole log is kept, to match rows up
+  # with the inferences that followed them.
+  log = {'rows': [], 'row_times': [], 'row_gaps': [], 'row_order': [],
+         'scores': [], 'score_times': [], 'score_order': [],
+         'feature_size': None, 'score_count': None, 'stride_ms': None}
+  order = 0
+  for header, records in ReadBlocks(data):
+    for key in ('feature_size', 'score_count', 'stride_ms'):
+      if log[key] is None:
+        log[key] = header[key]
+      elif log[key] != header[key]:
+        sys.exit('Block %d has %s %d, not %d' %
+                 (header['sequence'], key, header[key], log[key]))
+    feature_size = header['feature_size']
+    previous = bytearray(feature_size)
+    time_ms = 0
+    i = 0
+    while i < len(records):
+      kind = records[i] & TYPE_MASK
+      gap = bool(records[i] & ROW_GAP)
+      time_ms, i = ReadTime(records, i + 1, time_ms)
+      length, start = ReadVarint(records, i)
+      i = start + length
+      if kind == ROW:
+        delta = UnpackBits(records[start:i], feature_size)
+        row = bytearray((p + d) & 0xff for p, d in zip(previous, delta))
+        log['rows'].append(Signed(row))
+        log['row_times'].append(time_ms)
+        log['row_gaps'].append(1 if gap else 0)
+        log['row_order'].append(order)
+        previous = row
+      elif kind == SCORES:
+        log['scores'].append(Signed(records[start:i]))
+        log['score_times'].append(time_ms)
+        log['score_order'].append(order)
+      else:
+        sys.exit('Unknown record type %d in block %d' %
+                 (kind, header['sequence']))
+      order += 1
+  return log
+
+
+def Windows(log, window_slices, step):
+  """Returns the starts of runs of window_slices consecutive rows."""
+  starts = []
+  run_start = 0
+  times = log['row_times']
+  for i in range(len(times)):
+    if log['row_gaps'][i]:
+      run_start = i + 1
+      continue
+    if i > run_start and times[i] != times[i - 1] + log['stride_ms']:
+      run_start = i
+    length = i - run_start + 1
+    if length >= window_slices and (length - window_slices) % step == 0:
+      starts.append(i - window_slices + 1)
+  return starts
+
+
+def WriteNpy(path, descr, shape, values):
+  """Writes values, a flat array.array, as a .npy file."""
+  header = "{'descr': '%s', 'fortran_order': False, 'shape': (%s), }" % (
+      descr, ''.join('%d, ' % n for n in shape))
+  # The magic, version and length take 10 bytes, and the data starts on a
+  # 64 byte boundary after a newline.
+  padding = 64 - (10 + len(header) + 1) % 64
+  header += ' ' * (padding % 64) + '\n'
+  with open(path, 'wb') as f:
+    f.write(b'\x93NUMPY\x01\x00')
+    f.write(struct.pack('<H', len(header)))
+    f.write(header.encode('latin1'))
+    f.write(values.tobytes())
+
+
+def Flatten(rows, typecode):
+  values = array.array(typecode)
+  for row in rows:
+    values.extend(row)
+  return values
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('log', help='Feature log, such as a partition dump')
+  parser.add_argument('output', help='Directory for the .npy files')
+  parser.add_argument('--window-slices', type=int, default=49,
+                      help='Rows per window, kFeatureCount on the device')
+  parser.add_argument('--window-step', type=int, default=1,
+                      help='Rows between the starts of windows')
+  args = parser.parse_args()
+
+  log = ReadLog(args.log)
+  if not log['rows']:
+    sys.exit('No rows in %s' % args.log)
+  os.makedirs(args.output, exist_ok=True)
+  feature_size = log['feature_size']
+  score_count = log['score_count']
+  rows = log['rows']
+
+  def Output(name, descr, shape, values):
+    WriteNpy(os.path.join(args.output, name + '.npy'), descr, shape, values)
+
+  Output('rows', '|i1', (len(rows), feature_size), Flatten(rows, 'b'))
+  Output('row_times', '<i4', (len(rows),), array.array('i', log['row_times']))
+  Output('row_gaps', '|u1', (len(rows),), array.array('B', log['row_gaps']))
+  Output('scores', '|i1', (len(log['scores']), score_count),
+         Flatten(log['scores'], 'b'))
+  Output('score_times', '<i4', (len(log['scores']),),
+         array.array('i', log['score_times']))
+
+  starts = Windows(log, args.window_slices, args.window_step)
+  windows = array.array('b')
+  window_times = array.array('i')
+  window_scores = array.array('b')
+  score_index = 0
+  for start in starts:
+    end = start + args.window_slices
+    windows.extend(Flatten(rows[start:end], 'b'))
+    window_times.append(log['row_times'][end - 1])
+    while (score_index < len(log['scores']) and
+           log['score_order'][score_index] < log['row_order'][end - 1]):
+      score_index += 1
+    if score_index < len(log['scores']):
+      window_scores.extend(log['scores'][score_index])
+    else:
+      window_scores.extend([0] * score_count)
+  Output('windows', '|i1', (len(starts), args.window_slices, feature_size),
+         windows)
+  Output('window_times', '<i4', (len(starts),), window_times)
+  Output('window_scores', '|i1', (len(starts), score_count), window_scores)
+
+  gap_count = sum(log['row_gaps'])
+  print('%d rows (%d with gaps), %d inferences, %d windows of %d x %d' %
+        (len(rows), gap_count, len(log['scores']), len(starts),
+         args.window_slices, feature_size))
+
+
+if __name__ == '__main__':
+  main()
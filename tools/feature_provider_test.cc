@@ -0,0 +1,176 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host check that feature providers of different lengths can follow the same
+// audio side by side. A FeatureProvider and a ShortFeatureProvider populate
+// their windows from audio_provider.cc after every 100ms block, and every
+// row of both has to match the same slice computed by a lone AudioFrontend
+// that went through the audio in order. Sharing a frontend would advance its
+// noise estimate twice per slice and break that. It also checks that a run
+// of slices longer than the worker's buffer comes out as from one frontend.
+// tools/CMakeLists.txt builds and registers it when TFLITE_MICRO_DIR is set:
+//
+//   cmake -S tools -B build -DTFLITE_MICRO_DIR=<tflite-micro>
+//   cmake --build build && ctest --test-dir build
+//
+// It prints each failure and exits with 1 if there were any.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "audio_frontend.h"
+#include "audio_provider.h"
+#include "feature_provider.h"
+#include "host_microphone.h"
+#include "micro_features_generator.h"
+#include "micro_model_settings.h"
+
+namespace {
+
+// What CaptureSamples reads from I2S at a time.
+constexpr int kBlockSamples = kAudioSampleFrequency / 10;
+constexpr int kBlockCount = 40;
+// The audio from before recording started, which reads as silence, up to
+// the start of the first slice.
+constexpr int kLeadSamples =
+    kAudioSampleDurationCount - kAudioSampleStrideCount;
+// A run that the worker, if there is one, has to take in several pieces.
+constexpr int kLongRunSlices = 2 * kFeatureCount + 3;
+
+int g_failures = 0;
+
+void Fail(const char* what, int step) {
+  printf("FAIL at slice %d: %s\n", step, what);
+  ++g_failures;
+}
+
+// Noise that gets louder and quieter from block to block, so the noise
+// estimate keeps moving.
+std::vector<int16_t> MakeAudio(int sample_count) {
+  std::vector<int16_t> audio(sample_count);
+  uint32_t state = 12345;
+  for (int i = 0; i < sample_count; ++i) {
+    state = state * 1103515245 + 12345;
+    const int noise = static_cast<int>((state >> 16) & 0x7fff) - 0x4000;
+    const int loudness = 1 + (i / kBlockSamples) % 7;
+    audio[i] = static_cast<int16_t>(noise * loudness / 8);
+  }
+  return audio;
+}
+
+// Checks every row of a provider's window against the reference slices,
+// rows[0] being the silent seed of a warm started window and rows[step]
+// the slice that ends on step.
+template <typename Provider>
+void CheckWindow(const Provider& provider, int current_step,
+                 const std::vector<int8_t>& rows, const char* name) {
+  for (int slice = 0; slice < Provider::kFeatureCount; ++slice) {
+    const int step = current_step - Provider::kFeatureCount + 1 + slice;
+    const int8_t* expected = &rows[(step > 0 ? step : 0) * kFeatureSize];
+    if (memcmp(provider.SliceFeatures(slice), expected, kFeatureSize) != 0) {
+      printf("%s: ", name);
+      Fail("features differ from the lone frontend's", step);
+    }
+    if (provider.SliceHasGap(slice)) {
+      printf("%s: ", name);
+      Fail("flagged without a gap", step);
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  const std::vector<int16_t> audio = MakeAudio(kBlockCount * kBlockSamples);
+
+  // The reference: one frontend, seeded with a silent window as a warm
+  // start does, then every slice of the audio in order.
+  std::vector<int16_t> padded(kLeadSamples, 0);
+  padded.insert(padded.end(), audio.begin(), audio.end());
+  const int step_count = static_cast<int>(
+      (padded.size() - kAudioSampleDurationCount) / kAudioSampleStrideCount +
+      1);
+  static AudioFrontend reference;
+  std::vector<int8_t> rows((step_count + 1) * kFeatureSize);
+  const std::vector<int16_t> silence(kAudioSampleDurationCount, 0);
+  reference.Reset();
+  reference.ProcessSlices(silence.data(), 1, rows.data());
+  reference.ProcessSlices(padded.data(), step_count, &rows[kFeatureSize]);
+
+  HostMicrophoneSetAudio(audio.data(), audio.size());
+  // The capture task is started by the first fetch, which then waits for
+  // its first block, so that fetch has to be made from another thread.
+  std::thread start_capture([] {
+    int16_t unused;
+    GetAudioSamplesAt(0, 0, &unused);
+  });
+  HostMicrophoneRelease(1);
+  start_capture.join();
+
+  static int8_t long_data[FeatureProvider::kElementCount];
+  static int8_t short_data[ShortFeatureProvider::kElementCount];
+  static FeatureProvider long_provider(long_data);
+  static ShortFeatureProvider short_provider(short_data);
+  int32_t previous_time = 0;
+  for (int block = 2; block <= kBlockCount; ++block) {
+    HostMicrophoneRelease(block);
+    const int32_t current_time = LatestAudioTimestamp();
+    int how_many_new_slices = 0;
+    if (long_provider.PopulateFeatureData(previous_time, current_time,
+                                          &how_many_new_slices) != kTfLiteOk ||
+        short_provider.PopulateFeatureData(previous_time, current_time,
+                                           &how_many_new_slices) !=
+            kTfLiteOk) {
+      Fail("PopulateFeatureData failed", block);
+      continue;
+    }
+    previous_time = current_time;
+    const int current_step = current_time / kFeatureStrideMs;
+    CheckWindow(long_provider, current_step, rows, "long");
+    CheckWindow(short_provider, current_step, rows, "short");
+  }
+  if (long_provider.WindowHasGap() || short_provider.WindowHasGap()) {
+    printf("FAIL: a window still has a gap at the end\n");
+    ++g_failures;
+  }
+
+  // One long batch, against the reference started over.
+  static MicroFeaturesState state;
+  std::vector<int8_t> long_run(kLongRunSlices * kFeatureSize);
+  std::vector<int8_t> expected_run(kLongRunSlices * kFeatureSize);
+  if (InitializeMicroFeatures(&state) != kTfLiteOk ||
+      GenerateFeatureSlices(&state, padded.data(), kLongRunSlices,
+                            long_run.data()) != kTfLiteOk) {
+    Fail("GenerateFeatureSlices failed", kLongRunSlices);
+  }
+  reference.Reset();
+  reference.ProcessSlices(padded.data(), kLongRunSlices, expected_run.data());
+  if (long_run != expected_run) {
+    Fail("a long run differs from the lone frontend's", kLongRunSlices);
+  }
+
+  printf("%d slices through windows of %d and %d, and a run of %d\n",
+         step_count, FeatureProvider::kFeatureCount,
+         ShortFeatureProvider::kFeatureCount, kLongRunSlices);
+  if (g_failures > 0) {
+    printf("%d failures\n", g_failures);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
@@ -0,0 +1,115 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host benchmark of the audio frontend in each feature configuration, to
+// weigh up smaller input models before training them. The frontend has no
+// ESP-IDF dependencies, so it builds for the host as it is:
+//
+//   g++ -O2 -std=c++17 -Imain -o frontend_benchmark
+//       tools/frontend_benchmark.cc main/audio_frontend.cc
+//       main/frontend_stages.cc
+//   ./frontend_benchmark test_data/*_1000ms.wav
+//
+// For each configuration it prints the features per slice and the time per
+// slice, in TSC cycles on x86 and in nanoseconds everywhere. Host timings
+// only rank the configurations; RunFrontendBenchmark gives the ESP32-S3's.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "audio_frontend.h"
+#include "host_tools.h"
+
+namespace {
+
+constexpr int kRepeats = 50;
+
+template <int NumChannels>
+using Geometry = FrontendGeometry<kAudioSampleFrequency, kFeatureDurationMs,
+                                  kFeatureStrideMs, NumChannels>;
+
+// Streams every clip through Frontend, as the feature provider does, and
+// prints the time per slice.
+template <typename Frontend>
+void Benchmark(const char* name,
+               const std::vector<std::vector<int16_t>>& clips) {
+  static Frontend frontend;
+  std::vector<int8_t> features(Frontend::kFeatureCount);
+  long slices = 0;
+  uint64_t cycles = 0;
+  std::chrono::nanoseconds elapsed(0);
+  for (int repeat = 0; repeat < kRepeats; ++repeat) {
+    for (const std::vector<int16_t>& clip : clips) {
+      if (clip.size() < static_cast<size_t>(Frontend::kWindowSize)) {
+        continue;
+      }
+      const int slice_count =
+          (clip.size() - Frontend::kWindowSize) / Frontend::kStrideSize + 1;
+      frontend.Reset();
+      const auto start_time = std::chrono::steady_clock::now();
+      const uint64_t start_cycles = ReadCycles();
+      frontend.ProcessWindow(clip.data(), features.data());
+      for (int i = 1; i < slice_count; ++i) {
+        frontend.PushStride(clip.data() + Frontend::kOverlapCount +
+                                i * Frontend::kStrideSize,
+                            features.data());
+      }
+      cycles += ReadCycles() - start_cycles;
+      elapsed += std::chrono::steady_clock::now() - start_time;
+      slices += slice_count;
+    }
+  }
+  if (slices == 0) {
+    return;
+  }
+  printf("%-14s %4d %9d", name, Frontend::kFeatureCount,
+         Frontend::kFeatureCount * kFeatureCount);
+#if HOST_TIMING_HAVE_CYCLES
+  printf(" %10lu", static_cast<unsigned long>(cycles / slices));
+#endif
+  printf(" %8lu\n", static_cast<unsigned long>(elapsed.count() / slices));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s clip.wav...\n", argv[0]);
+    return 1;
+  }
+  std::vector<std::vector<int16_t>> clips;
+  for (int i = 1; i < argc; ++i) {
+    std::vector<int16_t> samples;
+    if (!ReadWav(argv[i], &samples)) {
+      return 1;
+    }
+    clips.push_back(samples);
+  }
+
+  printf("%-14s %4s %9s", "features", "size", "model in");
+#if HOST_TIMING_HAVE_CYCLES
+  printf(" %10s", "cycles");
+#endif
+  printf(" %8s\n", "ns");
+  Benchmark<BasicAudioFrontend<Geometry<40>>>("log mel 40", clips);
+  Benchmark<BasicAudioFrontend<Geometry<32>>>("log mel 32", clips);
+  Benchmark<BasicAudioFrontend<Geometry<40>, FrontendFeatureType::kMfcc, 13>>(
+      "MFCC 13 of 40", clips);
+  Benchmark<BasicAudioFrontend<Geometry<32>, FrontendFeatureType::kMfcc, 13>>(
+      "MFCC 13 of 32", clips);
+  return 0;
+}
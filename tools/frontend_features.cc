@@ -0,0 +1,158 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Computes the features of a list of clips on the host, with AudioFrontend
+// as configured by the MICRO_FEATURES_* settings it is built with.
+// frontend_sweep.py builds it once per setting; to build it by hand:
+//
+//   g++ -O2 -std=c++17 -Imain -DMICRO_FEATURES_STRIDE_MS=10 ...
+//       -o frontend_features tools/frontend_features.cc
+//       main/audio_frontend.cc main/frontend_stages.cc
+//       main/feature_log_format.cc
+//
+// It reads WAV paths from stdin, one per line. Each clip is cut or padded
+// with silence to kClipDurationMs, then its kFeatureCount rows of
+// kFeatureSize int8 features are appended to the output file, in the same
+// order. With --log, the output is a feature log instead, as the device
+// records with MICRO_SPEECH_FEATURE_LOG, with a break in time between
+// clips. The last line it prints is the geometry and the time per slice, as
+// key=value pairs.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "audio_frontend.h"
+#include "feature_log_format.h"
+#include "host_tools.h"
+
+namespace {
+
+constexpr int kClipSampleCount = kClipDurationMs * kAudioSampleFrequency / 1000;
+
+// Appends the rows of a clip to a feature log, filling blocks and writing
+// them out as they fill up.
+class LogWriter {
+ public:
+  explicit LogWriter(FILE* output)
+      : output_(output), encoder_(kFeatureSize, 0, kFeatureStrideMs) {
+    encoder_.StartBlock(block_, sequence_++);
+  }
+
+  bool AddRow(int32_t time_ms, const int8_t* row) {
+    if (encoder_.AddRow(time_ms, row, false)) {
+      return true;
+    }
+    if (!WriteBlock()) {
+      return false;
+    }
+    encoder_.StartBlock(block_, sequence_++);
+    return encoder_.AddRow(time_ms, row, false);
+  }
+
+  bool Finish() { return encoder_.BlockIsEmpty() || WriteBlock(); }
+
+ private:
+  bool WriteBlock() {
+    encoder_.FinishBlock();
+    return fwrite(block_, 1, kFeatureLogBlockSize, output_) ==
+           static_cast<size_t>(kFeatureLogBlockSize);
+  }
+
+  FILE* output_;
+  FeatureLogEncoder encoder_;
+  uint8_t block_[kFeatureLogBlockSize] = {};
+  uint32_t sequence_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const bool write_log = (argc == 3 && strcmp(argv[1], "--log") == 0);
+  if (argc != 2 && !write_log) {
+    fprintf(stderr, "Usage: %s [--log] features.bin < clips.txt\n", argv[0]);
+    return 1;
+  }
+  const char* output_path = argv[argc - 1];
+  FILE* output = fopen(output_path, "wb");
+  if (output == nullptr) {
+    fprintf(stderr, "Could not create %s\n", output_path);
+    return 1;
+  }
+  static LogWriter log_writer(output);
+
+  static AudioFrontend frontend;
+  std::vector<int8_t> features(kFeatureElementCount);
+  long clip_count = 0;
+  uint64_t cycles = 0;
+  std::chrono::nanoseconds elapsed(0);
+  std::string path;
+  while (std::getline(std::cin, path)) {
+    if (path.empty()) {
+      continue;
+    }
+    std::vector<int16_t> samples;
+    if (!ReadWav(path.c_str(), &samples)) {
+      fclose(output);
+      return 1;
+    }
+    samples.resize(kClipSampleCount, 0);
+
+    frontend.Reset();
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start_cycles = ReadCycles();
+    frontend.ProcessSlices(samples.data(), kFeatureCount, features.data());
+    cycles += ReadCycles() - start_cycles;
+    elapsed += std::chrono::steady_clock::now() - start_time;
+
+    bool written = true;
+    if (write_log) {
+      // Clips are a clip's length apart, so no window spans two of them.
+      const int32_t clip_ms = clip_count * 2 * kClipDurationMs;
+      for (int i = 0; i < kFeatureCount && written; ++i) {
+        written = log_writer.AddRow(
+            clip_ms + kFeatureDurationMs + i * kFeatureStrideMs,
+            features.data() + i * kFeatureSize);
+      }
+    } else {
+      written = fwrite(features.data(), 1, features.size(), output) ==
+                features.size();
+    }
+    if (!written) {
+      fprintf(stderr, "Could not write %s\n", output_path);
+      fclose(output);
+      return 1;
+    }
+    ++clip_count;
+  }
+  if (write_log && !log_writer.Finish()) {
+    fprintf(stderr, "Could not write %s\n", output_path);
+    fclose(output);
+    return 1;
+  }
+  fclose(output);
+
+  const long slices = clip_count * kFeatureCount;
+  printf("clips=%ld feature_count=%d feature_size=%d", clip_count,
+         kFeatureCount, kFeatureSize);
+  printf(" cycles_per_slice=%lu ns_per_slice=%lu\n",
+         static_cast<unsigned long>(slices ? cycles / slices : 0),
+         static_cast<unsigned long>(slices ? elapsed.count() / slices : 0));
+  return 0;
+}
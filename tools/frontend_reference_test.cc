@@ -0,0 +1,133 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host check that the native frontend is bit-exact with the preprocessor
+// model. Each clip's kFeatureCount slices are computed by
+// g_audio_preprocessor_int8_tflite through the TFLM interpreter, once with
+// the stock signal kernels and once with the ones from signal_kernels.h. They
+// must come out the same, from AudioFrontend too, and from the model fed one
+// stride at a time through GenerateStrideFeatures with a state of its own.
+// micro_features_generator.cc is built with
+// MICRO_FEATURES_USE_PREPROCESSOR_MODEL for it, which needs the whole of
+// TFLM, so tools/CMakeLists.txt only builds and registers it when
+// TFLITE_MICRO_LIB is set as well as TFLITE_MICRO_DIR:
+//
+//   make -f tensorflow/lite/micro/tools/make/Makefile microlite
+//   cmake -S tools -B build -DTFLITE_MICRO_DIR=<tflite-micro>
+//       -DTFLITE_MICRO_LIB=<tflite-micro>/gen/.../libtensorflow-microlite.a
+//   cmake --build build && ctest --test-dir build
+//
+// ctest runs it over test_data/*_1000ms.wav. It prints the features that
+// differ on each clip and exits with 1 if there were any.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "audio_frontend.h"
+#include "host_tools.h"
+#include "micro_features_generator.h"
+#include "micro_model_settings.h"
+
+#if !MICRO_FEATURES_USE_PREPROCESSOR_MODEL
+#error "Build with MICRO_FEATURES_USE_PREPROCESSOR_MODEL=1"
+#endif
+
+namespace {
+
+constexpr int kClipSampleCount =
+    (kFeatureCount - 1) * kAudioSampleStrideCount + kAudioSampleDurationCount;
+
+// Counts the features that differ between a and b.
+int CountMismatches(const Features& a, const Features& b) {
+  int mismatches = 0;
+  for (int i = 0; i < kFeatureCount; ++i) {
+    for (int j = 0; j < kFeatureSize; ++j) {
+      if (a[i][j] != b[i][j]) {
+        ++mismatches;
+      }
+    }
+  }
+  return mismatches;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s clip.wav...\n", argv[0]);
+    return 1;
+  }
+
+  static AudioFrontend frontend;
+  static MicroFeaturesState state;
+  static Features stock;
+  static Features fast;
+  static Features native;
+  static Features streamed;
+  int failures = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::vector<int16_t> samples;
+    if (!ReadWav(argv[i], &samples)) {
+      return 1;
+    }
+    // Cut or padded with silence to the length of a clip.
+    samples.resize(kClipSampleCount, 0);
+
+    if (GenerateReferenceFeatures(samples.data(), samples.size(), &stock,
+                                  SignalKernels::kStock) != kTfLiteOk ||
+        GenerateReferenceFeatures(samples.data(), samples.size(), &fast,
+                                  SignalKernels::kFast) != kTfLiteOk ||
+        InitializeMicroFeatures(&state) != kTfLiteOk ||
+        GenerateFeatureSlices(&state, samples.data(), 1, streamed[0]) !=
+            kTfLiteOk) {
+      printf("FAIL: %s: the preprocessor model failed\n", argv[i]);
+      ++failures;
+      continue;
+    }
+    for (int slice = 1; slice < kFeatureCount; ++slice) {
+      const int16_t* stride = samples.data() + AudioFrontend::kOverlapCount +
+                              slice * kAudioSampleStrideCount;
+      if (GenerateStrideFeatures(&state, stride, streamed[slice]) !=
+          kTfLiteOk) {
+        printf("FAIL: %s: streaming the model failed\n", argv[i]);
+        ++failures;
+        break;
+      }
+    }
+    frontend.Reset();
+    frontend.ProcessSlices(samples.data(), kFeatureCount, &native[0][0]);
+
+    const int fast_mismatches = CountMismatches(fast, stock);
+    const int native_mismatches = CountMismatches(native, stock);
+    const int streamed_mismatches = CountMismatches(streamed, stock);
+    printf("%s: %d of %d features differ from the stock kernels' with the "
+           "fast kernels, %d natively, %d streamed\n",
+           argv[i], fast_mismatches, kFeatureCount * kFeatureSize,
+           native_mismatches, streamed_mismatches);
+    if (fast_mismatches + native_mismatches + streamed_mismatches > 0) {
+      printf("FAIL: %s\n", argv[i]);
+      ++failures;
+    }
+  }
+
+  if (failures > 0) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
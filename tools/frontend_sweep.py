@@ -0,0 +1,345 @@
+# Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Sweeps the audio frontend's settings over a labelled corpus.
+
+For every combination of window length, stride, filterbank channels, PCAN
+and noise smoothing, builds tools/frontend_features.cc with the matching
+MICRO_FEATURES_* settings, computes the features of every clip in the corpus
+and reports the frontend's time per slice next to the accuracy a model
+reaches on those features.
+
+The corpus is laid out like the speech commands dataset: one directory of
+16 kHz mono WAV clips per label. Directories starting with "_" are skipped,
+and labels not given with --labels count as "unknown". Clips listed in
+validation_list.txt, or one in ten by a hash of their name if there is no
+such list, are held out for validation.
+
+Features are cached per setting under --cache, together with their timing
+and accuracy, and only recomputed when the setting, the corpus or the
+frontend sources change. Accuracies are also recomputed when the labels,
+the validation split or the evaluator, including any file it names, change.
+
+Accuracy comes from a nearest centroid classifier by default, which only
+needs the standard library and is good enough to rank settings. Pass
+--evaluator to train a real model instead: the command is run with the path
+of a JSON description of the dataset (see WriteDataset) appended, and the
+last line it prints must be the validation accuracy.
+
+Example:
+
+  python3 tools/frontend_sweep.py ~/speech_commands --labels yes,no \\
+      --stride-ms 10,20 --channels 40,32,24 --pcan 1,0
+"""
+
+import argparse
+import array
+import hashlib
+import itertools
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+
+REPO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAIN_DIR = os.path.join(REPO_DIR, 'main')
+TOOLS_DIR = os.path.join(REPO_DIR, 'tools')
+FRONTEND_SOURCES = [
+    os.path.join(TOOLS_DIR, 'frontend_features.cc'),
+    os.path.join(MAIN_DIR, 'audio_frontend.cc'),
+    os.path.join(MAIN_DIR, 'frontend_stages.cc'),
+    os.path.join(MAIN_DIR, 'feature_log_format.cc'),
+]
+FRONTEND_HEADERS = [
+    os.path.join(TOOLS_DIR, 'host_tools.h'),
+    os.path.join(MAIN_DIR, 'audio_frontend.h'),
+    os.path.join(MAIN_DIR, 'audio_frontend_tables.h'),
+    os.path.join(MAIN_DIR, 'frontend_stages.h'),
+    os.path.join(MAIN_DIR, 'feature_log_format.h'),
+    os.path.join(MAIN_DIR, 'micro_model_settings.h'),
+]
+UNKNOWN_LABEL = 'unknown'
+VALIDATION_PERCENT = 10
+
+
+class Setting(object):
+  """One combination of frontend settings."""
+
+  def __init__(self, window_ms, stride_ms, channels, pcan, smoothing):
+    self.window_ms = window_ms
+    self.stride_ms = stride_ms
+    self.channels = channels
+    self.pcan = pcan
+    self.smoothing = smoothing
+
+  def Name(self):
+    return 'w%d_s%d_c%d_pcan%d_n%d-%d' % (
+        self.window_ms, self.stride_ms, self.channels, self.pcan,
+        self.smoothing[0], self.smoothing[1])
+
+  def Defines(self):
+    return [
+        '-DMICRO_FEATURES_DURATION_MS=%d' % self.window_ms,
+        '-DMICRO_FEATURES_STRIDE_MS=%d' % self.stride_ms,
+        '-DMICRO_FEATURES_CHANNEL_COUNT=%d' % self.channels,
+        '-DMICRO_FEATURES_PCAN=%d' % self.pcan,
+        '-DMICRO_FEATURES_NOISE_SMOOTHING=%d' % self.smoothing[0],
+        '-DMICRO_FEATURES_NOISE_ALTERNATE_SMOOTHING=%d' % self.smoothing[1],
+    ]
+
+
+def ParseInts(text):
+  return [int(value) for value in text.split(',')]
+
+
+def ParseSmoothing(text):
+  """Parses "even/odd" pairs, or single values used for both."""
+  pairs = []
+  for value in text.split(','):
+    parts = [int(part) for part in value.split('/')]
+    pairs.append((parts[0], parts[-1]))
+  return pairs
+
+
+def ValidationByHash(name):
+  """Puts the same speaker in the same set, like the speech commands split."""
+  base = re.sub(r'_nohash_.*$', '', name)
+  digest = int(hashlib.sha1(base.encode('utf-8')).hexdigest(), 16)
+  return digest % 100 < VALIDATION_PERCENT
+
+
+def ListCorpus(corpus_dir, wanted_labels):
+  """Returns the clips as (path, label index, is_validation) and the labels."""
+  labels = list(wanted_labels) + [UNKNOWN_LABEL]
+  validation = None
+  validation_list = os.path.join(corpus_dir, 'validation_list.txt')
+  if os.path.exists(validation_list):
+    with open(validation_list) as f:
+      validation = set(line.strip() for line in f if line.strip())
+
+  clips = []
+  for directory in sorted(os.listdir(corpus_dir)):
+    label_dir = os.path.join(corpus_dir, directory)
+    if directory.startswith('_') or not os.path.isdir(label_dir):
+      continue
+    label = directory if directory in wanted_labels else UNKNOWN_LABEL
+    for name in sorted(os.listdir(label_dir)):
+      if not name.endswith('.wav'):
+        continue
+      relative = directory + '/' + name
+      if validation is not None:
+        is_validation = relative in validation
+      else:
+        is_validation = ValidationByHash(name)
+      clips.append((os.path.join(label_dir, name), labels.index(label),
+                    is_validation))
+  return clips, labels
+
+
+def CacheKey(setting, clips):
+  digest = hashlib.sha1()
+  digest.update(setting.Name().encode('utf-8'))
+  for path in FRONTEND_SOURCES + FRONTEND_HEADERS:
+    with open(path, 'rb') as f:
+      digest.update(f.read())
+  for path, _, _ in clips:
+    digest.update(path.encode('utf-8'))
+  return setting.Name() + '-' + digest.hexdigest()[:12]
+
+
+def AccuracyKey(clips, labels, evaluator):
+  """Names an accuracy by everything besides the features it depends on."""
+  digest = hashlib.sha1()
+  digest.update(json.dumps(labels).encode('utf-8'))
+  for path, label, is_validation in clips:
+    digest.update(('%s %d %d\n' % (path, label, is_validation)).encode('utf-8'))
+  if evaluator:
+    digest.update(evaluator.encode('utf-8'))
+    # The script or model definition an evaluator runs is usually one of its
+    # arguments, and editing it changes the accuracy as much as the command.
+    for argument in shlex.split(evaluator):
+      if os.path.isfile(argument):
+        with open(argument, 'rb') as f:
+          digest.update(f.read())
+  name = 'evaluator' if evaluator else 'nearest_centroid'
+  return name + '-' + digest.hexdigest()[:12]
+
+
+def BuildFrontend(setting, cxx, output):
+  command = ([cxx, '-O2', '-std=c++17', '-I' + MAIN_DIR] + setting.Defines() +
+             ['-o', output] + FRONTEND_SOURCES)
+  result = subprocess.run(command, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT, universal_newlines=True)
+  if result.returncode != 0:
+    errors = [line for line in result.stdout.splitlines() if 'error' in line]
+    return errors[0] if errors else 'build failed'
+  return None
+
+
+def ComputeFeatures(setting, clips, cache_dir, cxx):
+  """Returns the cached metadata of setting, computing it if needed."""
+  os.makedirs(cache_dir, exist_ok=True)
+  meta_path = os.path.join(cache_dir, 'meta.json')
+  if os.path.exists(meta_path):
+    with open(meta_path) as f:
+      return json.load(f)
+
+  binary = os.path.join(cache_dir, 'frontend_features')
+  error = BuildFrontend(setting, cxx, binary)
+  if error is not None:
+    meta = {'error': error}
+  else:
+    features_path = os.path.join(cache_dir, 'features.bin')
+    clip_list = ''.join(path + '\n' for path, _, _ in clips)
+    result = subprocess.run([binary, features_path], input=clip_list,
+                            stdout=subprocess.PIPE, universal_newlines=True)
+    if result.returncode != 0:
+      sys.exit('Computing features for %s failed' % setting.Name())
+    summary = result.stdout.strip().splitlines()[-1]
+    meta = {key: int(value) for key, value in
+            (item.split('=') for item in summary.split())}
+    meta['features'] = features_path
+    meta['accuracy'] = {}
+  with open(meta_path, 'w') as f:
+    json.dump(meta, f, indent=2)
+  return meta
+
+
+def WriteDataset(meta, clips, labels, cache_dir):
+  """Describes the cached features for an --evaluator command.
+
+  features.bin holds one row of feature_count * feature_size int8 values per
+  clip, in the order of the clips list. Each clip lists its label index into
+  labels and whether it is held out for validation.
+  """
+  path = os.path.join(cache_dir, 'dataset.json')
+  dataset = {
+      'features': meta['features'],
+      'feature_count': meta['feature_count'],
+      'feature_size': meta['feature_size'],
+      'labels': labels,
+      'clips': [{'path': path, 'label': label, 'validation': is_validation}
+                for path, label, is_validation in clips],
+  }
+  with open(path, 'w') as f:
+    json.dump(dataset, f)
+  return path
+
+
+def NearestCentroidAccuracy(meta, clips, label_count):
+  """Validation accuracy of the nearest training class mean."""
+  size = meta['feature_count'] * meta['feature_size']
+  features = array.array('b')
+  with open(meta['features'], 'rb') as f:
+    features.frombytes(f.read())
+
+  sums = [[0] * size for _ in range(label_count)]
+  counts = [0] * label_count
+  for index, (_, label, is_validation) in enumerate(clips):
+    if is_validation:
+      continue
+    row = features[index * size:(index + 1) * size]
+    total = sums[label]
+    for i in range(size):
+      total[i] += row[i]
+    counts[label] += 1
+  centroids = [[value / max(count, 1) for value in total]
+               for total, count in zip(sums, counts)]
+
+  correct = 0
+  tested = 0
+  for index, (_, label, is_validation) in enumerate(clips):
+    if not is_validation:
+      continue
+    row = features[index * size:(index + 1) * size]
+    distances = [sum((a - b) * (a - b) for a, b in zip(row, centroid))
+                 for centroid in centroids]
+    correct += distances.index(min(distances)) == label
+    tested += 1
+  return correct / tested if tested else 0.0
+
+
+def Evaluate(meta, clips, labels, cache_dir, evaluator, key):
+  if key in meta['accuracy']:
+    return meta['accuracy'][key]
+  if evaluator:
+    dataset = WriteDataset(meta, clips, labels, cache_dir)
+    result = subprocess.run(shlex.split(evaluator) + [dataset],
+                            stdout=subprocess.PIPE, universal_newlines=True)
+    if result.returncode != 0:
+      sys.exit('Evaluator failed on %s' % dataset)
+    accuracy = float(result.stdout.strip().splitlines()[-1])
+  else:
+    accuracy = NearestCentroidAccuracy(meta, clips, len(labels))
+  meta['accuracy'][key] = accuracy
+  with open(os.path.join(cache_dir, 'meta.json'), 'w') as f:
+    json.dump(meta, f, indent=2)
+  return accuracy
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__.split('\n\n')[0],
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('corpus', help='Directory of label directories of clips')
+  parser.add_argument('--labels', default='yes,no',
+                      help='Labels to tell apart, the rest are unknown')
+  parser.add_argument('--window-ms', type=ParseInts, default=[30])
+  parser.add_argument('--stride-ms', type=ParseInts, default=[20])
+  parser.add_argument('--channels', type=ParseInts, default=[40])
+  parser.add_argument('--pcan', type=ParseInts, default=[1])
+  parser.add_argument('--smoothing', type=ParseSmoothing, default=[(25, 60)],
+                      help='Noise smoothing per slice in thousandths, as '
+                      'even/odd channel pairs')
+  parser.add_argument('--cache', default=os.path.join(REPO_DIR, 'build',
+                                                      'frontend_sweep'))
+  parser.add_argument('--evaluator', default='',
+                      help='Command that trains a model on a dataset.json '
+                      'and prints its validation accuracy')
+  parser.add_argument('--cxx', default='g++')
+  args = parser.parse_args()
+
+  clips, labels = ListCorpus(args.corpus, args.labels.split(','))
+  if not clips:
+    sys.exit('No clips found in %s' % args.corpus)
+  validation_count = sum(1 for clip in clips if clip[2])
+  if validation_count == 0 or validation_count == len(clips):
+    sys.exit('Need clips both to train on and to validate with')
+  print('%d clips, %d for validation, labels %s' %
+        (len(clips), validation_count, ', '.join(labels)))
+
+  print('%-28s %6s %6s %8s %10s %8s %8s' %
+        ('setting', 'slices', 'size', 'model in', 'cycles', 'ns',
+         'accuracy'))
+  accuracy_key = AccuracyKey(clips, labels, args.evaluator)
+  for values in itertools.product(args.window_ms, args.stride_ms,
+                                  args.channels, args.pcan, args.smoothing):
+    setting = Setting(*values)
+    cache_dir = os.path.join(args.cache, CacheKey(setting, clips))
+    meta = ComputeFeatures(setting, clips, cache_dir, args.cxx)
+    if 'error' in meta:
+      print('%-28s not buildable: %s' % (setting.Name(), meta['error']))
+      continue
+    accuracy = Evaluate(meta, clips, labels, cache_dir, args.evaluator,
+                        accuracy_key)
+    print('%-28s %6d %6d %8d %10d %8d %8.3f' %
+          (setting.Name(), meta['feature_count'], meta['feature_size'],
+           meta['feature_count'] * meta['feature_size'],
+           meta['cycles_per_slice'], meta['ns_per_slice'], accuracy))
+
+
+if __name__ == '__main__':
+  main()
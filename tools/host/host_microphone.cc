@@ -0,0 +1,104 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "host_microphone.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#include "driver/i2s.h"
+
+namespace {
+
+struct Microphone {
+  std::mutex mutex;
+  std::condition_variable changed;
+  const int16_t* samples = nullptr;
+  int sample_count = 0;
+  int next_sample = 0;
+  // Blocks i2s_read may return, has returned, and that the capture task has
+  // finished with, which it has once it asks for the next one.
+  int released_blocks = 0;
+  int read_blocks = 0;
+  int finished_blocks = 0;
+};
+
+// Never destroyed, as the capture task is still waiting on it at exit.
+Microphone& GetMicrophone() {
+  static Microphone* microphone = new Microphone;
+  return *microphone;
+}
+
+}  // namespace
+
+void HostMicrophoneSetAudio(const int16_t* samples, int sample_count) {
+  Microphone& microphone = GetMicrophone();
+  std::lock_guard<std::mutex> lock(microphone.mutex);
+  microphone.samples = samples;
+  microphone.sample_count = sample_count;
+  microphone.next_sample = 0;
+}
+
+void HostMicrophoneRelease(int block_count) {
+  Microphone& microphone = GetMicrophone();
+  std::unique_lock<std::mutex> lock(microphone.mutex);
+  microphone.released_blocks = block_count;
+  microphone.changed.notify_all();
+  microphone.changed.wait(lock, [&microphone, block_count] {
+    return microphone.finished_blocks >= block_count ||
+           (microphone.finished_blocks == microphone.read_blocks &&
+            microphone.next_sample >= microphone.sample_count);
+  });
+}
+
+extern "C" {
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t* config,
+                             int queue_size, void* queue) {
+  return ESP_OK;
+}
+
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t* pins) {
+  return ESP_OK;
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port) { return ESP_OK; }
+
+// Blocks until the test releases another block, however long that takes,
+// so the capture task only ever sees whole blocks.
+esp_err_t i2s_read(i2s_port_t port, void* dest, size_t size,
+                   size_t* bytes_read, TickType_t ticks_to_wait) {
+  Microphone& microphone = GetMicrophone();
+  std::unique_lock<std::mutex> lock(microphone.mutex);
+  microphone.finished_blocks = microphone.read_blocks;
+  microphone.changed.notify_all();
+  microphone.changed.wait(lock, [&microphone] {
+    return microphone.read_blocks < microphone.released_blocks &&
+           microphone.next_sample < microphone.sample_count;
+  });
+  const int sample_count =
+      std::min<int>(size / sizeof(int16_t),
+                    microphone.sample_count - microphone.next_sample);
+  memcpy(dest, microphone.samples + microphone.next_sample,
+         sample_count * sizeof(int16_t));
+  microphone.next_sample += sample_count;
+  ++microphone.read_blocks;
+  *bytes_read = sample_count * sizeof(int16_t);
+  return ESP_OK;
+}
+
+}  // extern "C"
@@ -0,0 +1,33 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_TOOLS_HOST_HOST_MICROPHONE_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_TOOLS_HOST_HOST_MICROPHONE_H_
+
+// The microphone behind i2s_read on the host, so that a test can run
+// audio_provider.cc's capture task over audio it chooses, a block at a time.
+
+#include <cstdint>
+
+// Sets the audio that i2s_read hands out, in order, as many bytes per call
+// as it is asked for. samples must stay valid while the capture task runs.
+void HostMicrophoneSetAudio(const int16_t* samples, int sample_count);
+
+// Lets i2s_read return up to block_count blocks in total, and waits until the
+// capture task has dealt with all of them and is back asking for the next.
+// Blocks past the end of the audio are never returned.
+void HostMicrophoneRelease(int block_count);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_TOOLS_HOST_HOST_MICROPHONE_H_
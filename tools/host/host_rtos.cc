@@ -0,0 +1,122 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The FreeRTOS and esp_timer calls of the device sources, on host threads.
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable given;
+  bool available;
+};
+
+namespace {
+
+std::recursive_mutex g_critical_lock;
+
+SemaphoreHandle_t CreateSemaphore(bool available) {
+  SemaphoreHandle_t semaphore = new HostSemaphore;
+  semaphore->available = available;
+  return semaphore;
+}
+
+}  // namespace
+
+extern "C" {
+
+void HostEnterCritical(void) { g_critical_lock.lock(); }
+
+void HostExitCritical(void) { g_critical_lock.unlock(); }
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+  return CreateSemaphore(false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return CreateSemaphore(true); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore,
+                          TickType_t ticks_to_wait) {
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  if (ticks_to_wait == portMAX_DELAY) {
+    semaphore->given.wait(lock, [semaphore] { return semaphore->available; });
+  } else if (!semaphore->given.wait_for(
+                 lock, std::chrono::milliseconds(ticks_to_wait),
+                 [semaphore] { return semaphore->available; })) {
+    return pdFALSE;
+  }
+  semaphore->available = false;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(semaphore->mutex);
+  if (semaphore->available) {
+    return pdFALSE;
+  }
+  semaphore->available = true;
+  semaphore->given.notify_one();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name,
+                       uint32_t stack_size, void* arg, UBaseType_t priority,
+                       TaskHandle_t* handle) {
+  std::thread task(function, arg);
+  if (handle != nullptr) {
+    // Only ever compared against nullptr by the device sources.
+    *handle = reinterpret_cast<TaskHandle_t>(task.native_handle());
+  }
+  task.detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name,
+                                   uint32_t stack_size, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core) {
+  return xTaskCreate(function, name, stack_size, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task == nullptr) {
+    pthread_exit(nullptr);
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+int64_t esp_timer_get_time(void) {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // extern "C"
@@ -0,0 +1,76 @@
+/* Copyright 2025 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_TOOLS_HOST_TOOLS_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_TOOLS_HOST_TOOLS_H_
+
+// Helpers shared by the host tools that run the frontend outside ESP-IDF.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HOST_TIMING_HAVE_CYCLES 1
+#else
+#define HOST_TIMING_HAVE_CYCLES 0
+#endif
+
+// The time stamp counter where there is one, 0 elsewhere.
+inline uint64_t ReadCycles() {
+#if HOST_TIMING_HAVE_CYCLES
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Reads the samples of a 16 bit mono WAV file.
+inline bool ReadWav(const char* path, std::vector<int16_t>* samples) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "Could not open %s\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + read);
+  }
+  fclose(file);
+
+  size_t position = 12;
+  while (position + 8 <= data.size()) {
+    uint32_t chunk_size;
+    memcpy(&chunk_size, &data[position + 4], sizeof(chunk_size));
+    if (memcmp(&data[position], "data", 4) == 0) {
+      const size_t end = std::min<size_t>(data.size(),
+                                          position + 8 + chunk_size);
+      samples->resize((end - position - 8) / sizeof(int16_t));
+      memcpy(samples->data(), &data[position + 8],
+             samples->size() * sizeof(int16_t));
+      return true;
+    }
+    position += 8 + chunk_size;
+  }
+  fprintf(stderr, "No data chunk in %s\n", path);
+  return false;
+}
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_TOOLS_HOST_TOOLS_H_